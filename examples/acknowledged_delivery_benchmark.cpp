@@ -0,0 +1,131 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include "event_bus.hpp"
+
+using namespace eventbus;
+using namespace std::chrono_literals;
+
+/**
+ * Acknowledged Delivery Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - What at least once delivery costs: an acknowledged group keeps every dequeued event in its slot until the
+ *   consumer acknowledges it, per batch or per event
+ * - Whether events survive consumers that fail in the middle of a batch
+ *
+ * TESTING SETUP:
+ * One producer publishes EVENTS events, keyed over KEYS keys, into one topic with PARTITIONS partitions and BLOCK
+ * back-pressure. One consumer thread polls batches of BATCH events.
+ * - plain: regular group, nothing to acknowledge
+ * - ack per batch: acknowledged group, acknowledge() after every batch
+ * - ack per event: acknowledged group, acknowledge(event) after every event
+ * - failing consumer: ack per batch, but every FAILURE_EVERY-th batch the consumer "crashes" halfway through it,
+ *   and the consumer taking over calls redeliver_unacknowledged()
+ *
+ * KEY METRICS MEASURED:
+ * - Nanoseconds per event from the first publish until the consumer handled the last one
+ * - Events never handled (lost) and events handled more than once (redelivered)
+ */
+
+constexpr size_t PARTITIONS = 8;
+constexpr int EVENTS = 1000000;
+constexpr int KEYS = 64;
+constexpr size_t BATCH = 256;
+constexpr size_t FAILURE_EVERY = 100;
+
+enum class Mode { PLAIN, ACK_PER_BATCH, ACK_PER_EVENT, FAILING_CONSUMER };
+
+struct Result {
+    double ns_per_event = 0;
+    size_t lost = 0;
+    size_t redelivered = 0;
+};
+
+Result run(const Mode mode) {
+    const bool acknowledged = mode != Mode::PLAIN;
+    TopicConfig topic;
+    topic.name = "orders";
+    topic.partition_count = PARTITIONS;
+    topic.queue_capacity = 4096;
+    ConsumerGroupConfig group;
+    group.group_id = "routers";
+    group.topic_name = "orders";
+    group.consumer_count = 1;
+    group.acknowledged = acknowledged;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back(group);
+    BackPressureConfig back_pressure;
+    back_pressure.strategy = BackPressureStrategy::BLOCK;
+    EventBus event_bus(config, back_pressure);
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("routers")[0];
+
+    std::vector<std::string> keys;
+    for (int k = 0; k < KEYS; ++k) {
+        keys.push_back("account-" + std::to_string(k));
+    }
+
+    std::vector<uint32_t> handled(EVENTS, 0);
+    const auto start_time = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        for (int i = 0; i < EVENTS; ++i) {
+            event_bus.publish_event(Event("orders", "route"), keys[i % KEYS]); // ids are 0, 1, 2, ... from one producer
+        }
+    });
+
+    size_t distinct = 0;
+    size_t batches = 0;
+    const auto deadline = start_time + 60s;
+    while (distinct < EVENTS && std::chrono::steady_clock::now() < deadline) {
+        const auto& batch = consumer.poll_batch(BATCH);
+        if (batch.empty()) {
+            continue;
+        }
+        const bool fails = mode == Mode::FAILING_CONSUMER && ++batches % FAILURE_EVERY == 0;
+        const size_t handle = fails ? batch.size() / 2 : batch.size();
+        for (size_t i = 0; i < handle; ++i) {
+            distinct += handled[batch[i].id]++ == 0 ? 1 : 0;
+            if (mode == Mode::ACK_PER_EVENT) {
+                consumer.acknowledge(batch[i]);
+            }
+        }
+        if (fails) {
+            consumer.redeliver_unacknowledged(); // the replacement starts here
+        } else if (acknowledged && mode != Mode::ACK_PER_EVENT) {
+            consumer.acknowledge();
+        }
+    }
+    producer.join();
+
+    Result result;
+    result.ns_per_event = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count() /
+        EVENTS;
+    for (const uint32_t count : handled) {
+        result.lost += count == 0 ? 1 : 0;
+        result.redelivered += count > 1 ? count - 1 : 0;
+    }
+    return result;
+}
+
+int main() {
+    try {
+        std::cout << "=== Acknowledged Delivery Benchmark ===\n";
+        std::cout << EVENTS << " events over " << PARTITIONS << " partitions, batches of " << BATCH << "\n\n";
+        std::cout << std::setw(20) << "mode" << std::setw(16) << "ns per event" << std::setw(10) << "lost"
+                  << std::setw(14) << "redelivered" << "\n";
+        for (const Mode mode : {Mode::PLAIN, Mode::ACK_PER_BATCH, Mode::ACK_PER_EVENT, Mode::FAILING_CONSUMER}) {
+            const Result result = run(mode);
+            const char* name = mode == Mode::PLAIN ? "plain" : mode == Mode::ACK_PER_BATCH ? "ack per batch" :
+                mode == Mode::ACK_PER_EVENT ? "ack per event" : "failing consumer";
+            std::cout << std::setw(20) << name << std::fixed << std::setprecision(1) << std::setw(16)
+                      << result.ns_per_event << std::setw(10) << result.lost << std::setw(14) << result.redelivered << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
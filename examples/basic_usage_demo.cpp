@@ -2,6 +2,7 @@
 #include <thread>
 #include <chrono>
 #include <numeric>
+#include <algorithm>
 
 #include "event_bus.hpp"
 #include "consumer.hpp"
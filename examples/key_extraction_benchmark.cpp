@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include "event_bus.hpp"
+#include "json_key_scanner.hpp"
+
+using namespace eventbus;
+
+/**
+ * Key Extraction Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - What JsonKeyScanner costs per payload against the string search producers hand roll today
+ * - Publish cost with the key extracted by the topic (TopicConfig::partition_key_field) against passing it
+ *
+ * TESTING SETUP:
+ * Part 1: ITERATIONS extractions of "sym" from a small quote payload like the other benchmarks use, and from
+ *   the same payload behind about 1KB of other fields, where the SIMD scan skips string contents 16 bytes at a time.
+ *   The hand rolled search is std::string::find on "\"sym\":\"", which is faster but wrong for nested objects,
+ *   whitespace around the colon or the key showing up inside a string.
+ * Part 2: PUBLISHES publish_event calls on an 8 partition topic with one consumer group, drained as we go.
+ *
+ * KEY METRICS MEASURED:
+ * - Nanoseconds per extraction
+ * - Nanoseconds per publish
+ */
+
+constexpr int ITERATIONS = 2000000;
+constexpr int PUBLISHES = 1000000;
+
+std::string_view hand_rolled_key(const std::string& payload) {
+    const size_t start = payload.find("\"sym\":\"");
+    if (start == std::string::npos) {
+        return {};
+    }
+    const size_t end = payload.find('"', start + 7);
+    return std::string_view(payload).substr(start + 7, end - start - 7);
+}
+
+template<typename Extract>
+double ns_per_call(const std::string& payload, Extract&& extract) {
+    size_t checksum = 0;
+    const auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        checksum += extract(payload).size();
+    }
+    const auto end_time = std::chrono::steady_clock::now();
+    if (checksum == 0) {
+        std::cout << "(no key found)\n";
+    }
+    return std::chrono::duration<double, std::nano>(end_time - start_time).count() / ITERATIONS;
+}
+
+double ns_per_publish(const bool extract_in_topic) {
+    TopicConfig topic;
+    topic.name = "quotes";
+    topic.partition_count = 8;
+    topic.queue_capacity = 16384;
+    if (extract_in_topic) {
+        topic.partition_key_field = "sym";
+    }
+    ConsumerGroupConfig group;
+    group.group_id = "pricers";
+    group.topic_name = "quotes";
+    group.consumer_count = 1;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back(group);
+    EventBus event_bus(config);
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("pricers")[0];
+    const char* symbols[] = {"AAPL", "MSFT", "GOOG", "AMZN", "NVDA", "META", "TSLA", "NFLX"};
+    std::vector<Event> events;
+    for (int i = 0; i < 64; ++i) {
+        events.emplace_back("quotes", R"({"id":)" + std::to_string(i) + R"(,"sym":")" + symbols[i % 8] +
+            R"(","px":150.25,"qty":100})");
+    }
+
+    double total_ns = 0;
+    for (int i = 0; i < PUBLISHES; ++i) {
+        const Event& event = events[i % events.size()];
+        const auto start_time = std::chrono::steady_clock::now();
+        if (extract_in_topic) {
+            event_bus.publish_event(event);
+        } else {
+            event_bus.publish_event(event, std::string(hand_rolled_key(event.payload)));
+        }
+        total_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+        if (i % 4096 == 4095) {
+            while (!consumer.poll_batch(16384).empty()) {}
+        }
+    }
+    return total_ns / PUBLISHES;
+}
+
+int main() {
+    try {
+        const std::string small = R"({"id":12345,"sym":"AAPL","px":150.25,"qty":100,"side":"B"})";
+        const std::string large = R"({"id":12345,"venue":"XNAS","notes":")" + std::string(1000, 'n') +
+            R"(","book":{"bids":[[150.24,300],[150.23,500]],"asks":[[150.26,200]]},"sym":"AAPL","px":150.25})";
+        const JsonKeyScanner scanner("sym");
+        const auto scan = [&](const std::string& payload) {
+            std::string_view key;
+            scanner.extract(payload, key);
+            return key;
+        };
+
+        std::cout << "=== Key Extraction Benchmark ===\n";
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::setw(24) << "payload" << std::setw(18) << "scanner (ns)" << std::setw(18) << "find (ns)" << "\n";
+        std::cout << std::setw(24) << ("small (" + std::to_string(small.size()) + "B)")
+                  << std::setw(18) << ns_per_call(small, scan) << std::setw(18) << ns_per_call(small, hand_rolled_key) << "\n";
+        std::cout << std::setw(24) << ("large (" + std::to_string(large.size()) + "B)")
+                  << std::setw(18) << ns_per_call(large, scan) << std::setw(18) << ns_per_call(large, hand_rolled_key) << "\n\n";
+
+        std::cout << std::setw(24) << "publish" << std::setw(18) << "ns per event" << "\n";
+        std::cout << std::setw(24) << "key passed" << std::setw(18) << ns_per_publish(false) << "\n";
+        std::cout << std::setw(24) << "key extracted by topic" << std::setw(18) << ns_per_publish(true) << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
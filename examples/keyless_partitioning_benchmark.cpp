@@ -0,0 +1,137 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include "event_bus.hpp"
+
+using namespace eventbus;
+using namespace std::chrono_literals;
+
+/**
+ * Keyless Partitioning Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - ROUND_ROBIN against LEAST_LOADED keyless partitioning when one consumer of the group stalls
+ * - Whether the power of two choices steers events away from the backlogged partition
+ *
+ * TESTING SETUP:
+ * One topic with PARTITIONS partitions of RING_CAPACITY slots, one consumer group with one consumer per partition,
+ * DROP_NEWEST back-pressure. One producer publishes keyless events at a steady rate of about one event per
+ * PUBLISH_INTERVAL. Every consumer drains its partition as fast as it can, except consumer 0 which stalls for
+ * STALL_DURATION every STALL_PERIOD, long enough to fill its ring.
+ *
+ * KEY METRICS MEASURED:
+ * - Events dropped because the picked partition was full
+ * - p50 / p99 / max time from publish to poll
+ */
+
+constexpr size_t PARTITIONS = 4;
+constexpr size_t RING_CAPACITY = 1024;
+constexpr int EVENTS = 400000;
+constexpr auto PUBLISH_INTERVAL = 2us;
+constexpr auto STALL_PERIOD = 20ms;
+constexpr auto STALL_DURATION = 10ms;
+
+struct Result {
+    size_t dropped = 0;
+    std::vector<double> latencies_us;
+};
+
+Result run(const KeylessPartitioning keyless_partitioning) {
+    TopicConfig topic;
+    topic.name = "work";
+    topic.partition_count = PARTITIONS;
+    topic.queue_capacity = RING_CAPACITY;
+    topic.keyless_partitioning = keyless_partitioning;
+    ConsumerGroupConfig group;
+    group.group_id = "workers";
+    group.topic_name = "work";
+    group.consumer_count = PARTITIONS;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back(group);
+    BackPressureConfig back_pressure;
+    back_pressure.strategy = BackPressureStrategy::DROP_NEWEST;
+    EventBus event_bus(config, back_pressure);
+    const auto& consumers = event_bus.consumers_by_consumer_group_id().at("workers");
+
+    std::atomic<bool> producing{true};
+    std::vector<std::vector<double>> latencies(consumers.size());
+    std::vector<std::thread> consumer_threads;
+    for (size_t c = 0; c < consumers.size(); ++c) {
+        consumer_threads.emplace_back([&, c] {
+            auto next_stall = std::chrono::steady_clock::now() + STALL_PERIOD;
+            while (true) {
+                const bool still_producing = producing.load(std::memory_order_acquire);
+                const auto& batch = consumers[c]->poll_batch(256);
+                const auto now = std::chrono::steady_clock::now();
+                for (const auto& event : batch) {
+                    latencies[c].push_back(std::chrono::duration<double, std::micro>(now - event.timestamp).count());
+                }
+                if (batch.empty()) {
+                    if (!still_producing) {
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+                if (c == 0 && now >= next_stall) {
+                    std::this_thread::sleep_for(STALL_DURATION);
+                    next_stall = std::chrono::steady_clock::now() + STALL_PERIOD;
+                }
+            }
+        });
+    }
+
+    Result result;
+    auto next_publish = std::chrono::steady_clock::now();
+    for (int i = 0; i < EVENTS; ++i) {
+        while (std::chrono::steady_clock::now() < next_publish) {}
+        next_publish += PUBLISH_INTERVAL;
+        if (!event_bus.publish_event(Event("work", R"({"job":42,"cost":7})"))) {
+            ++result.dropped;
+        }
+    }
+    producing.store(false, std::memory_order_release);
+    for (auto& thread : consumer_threads) {
+        thread.join();
+    }
+    for (auto& consumer_latencies : latencies) {
+        result.latencies_us.insert(result.latencies_us.end(), consumer_latencies.begin(), consumer_latencies.end());
+    }
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+double percentile(const std::vector<double>& sorted, const double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+}
+
+int main() {
+    try {
+        std::cout << "=== Keyless Partitioning Benchmark ===\n";
+        std::cout << PARTITIONS << " partitions x " << RING_CAPACITY << " slots, " << EVENTS
+                  << " keyless events, consumer 0 stalls " << STALL_DURATION.count() << "ms every "
+                  << STALL_PERIOD.count() << "ms\n\n";
+        std::cout << std::setw(14) << "partitioning" << std::setw(12) << "dropped" << std::setw(12) << "p50 (us)"
+                  << std::setw(12) << "p99 (us)" << std::setw(12) << "max (us)" << "\n";
+        for (const auto keyless_partitioning : {KeylessPartitioning::ROUND_ROBIN, KeylessPartitioning::LEAST_LOADED}) {
+            const Result result = run(keyless_partitioning);
+            std::cout << std::setw(14) << (keyless_partitioning == KeylessPartitioning::ROUND_ROBIN ? "ROUND_ROBIN" : "LEAST_LOADED")
+                      << std::setw(12) << result.dropped
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(12) << percentile(result.latencies_us, 0.50)
+                      << std::setw(12) << percentile(result.latencies_us, 0.99)
+                      << std::setw(12) << (result.latencies_us.empty() ? 0.0 : result.latencies_us.back()) << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
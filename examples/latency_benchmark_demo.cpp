@@ -255,7 +255,7 @@ private:
         if (total_consumed.load() != published_count) {
             std::cerr << "WARNING: Event count mismatch! "
                      << (published_count - total_consumed.load()) << " events missing!\n";
-        } else if (latencies.size() != published_count) {
+        } else if (latencies.size() != static_cast<size_t>(published_count)) {
             std::cerr << "WARNING: Latency sample count mismatch!\n";
         } else {
             std::cout << "All events successfully processed\n";
@@ -349,7 +349,7 @@ private:
         if (consumed_count.load() != published_count) {
             std::cerr << "WARNING: Event count mismatch! "
                      << (published_count - consumed_count.load()) << " events missing!\n";
-        } else if (latencies.size() != published_count) {
+        } else if (latencies.size() != static_cast<size_t>(published_count)) {
             std::cerr << "WARNING: Latency sample count mismatch!\n";
         } else {
             std::cout << "All events successfully processed\n";
@@ -92,7 +92,7 @@ public:
         while (events_processed < target_events) {
             auto events = consumer.poll_batch(100);
             if (!events.empty()) {
-                for (const auto& event : events) {
+                for ([[maybe_unused]] const auto& event : events) {
                     volatile int x = 0;
                     // artifical cpu work
                     for (int i = 0; i < 1000000; ++i) {
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include "event_bus.hpp"
+#include "consumer.hpp"
+#include "event.hpp"
+
+using namespace eventbus;
+using namespace std::chrono_literals;
+
+/**
+ * Queue Engine Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - CAS_RING (LockFreeMpscQueue) against FETCH_ADD_RING (FetchAddMpscQueue) as the producer count grows
+ * - Whether fetch_add slot claiming keeps its throughput where the CAS retry loop starts to collapse
+ * - How much RELAXED_RING (RelaxedMpscQueue) gains by giving up FIFO order within the partition
+ *
+ * TESTING SETUP:
+ * Part 1: raw rings, 1 consumer thread and 1 / 2 / 4 / 8 / 16 producer threads on a single 16K ring.
+ *   Every producer pushes its share of 2M events, retrying while the ring is full, so we measure
+ *   the contended claim path rather than back-pressure.
+ * Part 2: the same producer counts through a 1 partition EventBus topic with BLOCK back-pressure,
+ *   once per engine selected with TopicConfig::queue_engine.
+ *
+ * KEY METRICS MEASURED:
+ * - Throughput (events/second) per engine and producer count
+ * - Ratio of each engine against CAS_RING
+ *
+ * Results depend heavily on the core count, run on a machine with at least as many cores as producers.
+ */
+
+template<typename Queue>
+double run_raw_ring(const int producers, const int total_events) {
+    Queue queue(16384);
+    const int events_per_producer = total_events / producers;
+    const int expected = events_per_producer * producers;
+    std::atomic<bool> start{false};
+
+    std::vector<std::thread> producer_threads;
+    for (int p = 0; p < producers; ++p) {
+        producer_threads.emplace_back([&] {
+            const Event event("bench", R"({"sym":"AAPL","px":150.25,"qty":100})");
+            while (!start.load(std::memory_order_acquire)) {}
+            for (int i = 0; i < events_per_producer; ++i) {
+                while (!queue.enqueue(event)) {}
+            }
+        });
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    Event event;
+    for (int consumed = 0; consumed < expected;) {
+        if (queue.dequeue(event)) {
+            ++consumed;
+        }
+    }
+    const auto end_time = std::chrono::steady_clock::now();
+    for (auto& t : producer_threads) {
+        t.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(end_time - start_time).count();
+    return seconds > 0 ? expected / seconds : 0.0;
+}
+
+double run_bus(const QueueEngine engine, const int producers, const int total_events) {
+    const EventBusConfig config {
+        .topics = {
+            {"bench", 1, 16384, 0, engine}
+        },
+        .consumer_groups = {
+            {"bench_group", "bench", 1}
+        }
+    };
+    EventBus event_bus(config, {BackPressureStrategy::BLOCK});
+    const auto& consumer = event_bus.consumers_by_consumer_group_id().at("bench_group")[0];
+    const int events_per_producer = total_events / producers;
+    const size_t expected = static_cast<size_t>(events_per_producer) * producers;
+    std::atomic<bool> start{false};
+
+    std::vector<std::thread> producer_threads;
+    for (int p = 0; p < producers; ++p) {
+        producer_threads.emplace_back([&] {
+            const Event event("bench", R"({"sym":"AAPL","px":150.25,"qty":100})");
+            while (!start.load(std::memory_order_acquire)) {}
+            for (int i = 0; i < events_per_producer; ++i) {
+                event_bus.publish_event(event);
+            }
+        });
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (size_t consumed = 0; consumed < expected;) {
+        consumed += consumer->poll_batch(256).size();
+    }
+    const auto end_time = std::chrono::steady_clock::now();
+    for (auto& t : producer_threads) {
+        t.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(end_time - start_time).count();
+    return seconds > 0 ? expected / seconds : 0.0;
+}
+
+void print_header() {
+    std::cout << std::setw(10) << "producers" << std::setw(14) << "CAS_RING"
+              << std::setw(24) << "FETCH_ADD_RING" << std::setw(24) << "RELAXED_RING" << "\n";
+}
+
+void print_row(const int producers, const double cas, const double fetch_add, const double relaxed) {
+    const auto ratio = [cas](const double value) { return cas > 0 ? value / cas : 0.0; };
+    std::cout << std::setw(10) << producers
+              << std::setw(14) << std::fixed << std::setprecision(0) << cas
+              << std::setw(16) << fetch_add << " (" << std::setprecision(2) << ratio(fetch_add) << "x)"
+              << std::setw(16) << std::setprecision(0) << relaxed << " (" << std::setprecision(2) << ratio(relaxed) << "x)\n";
+}
+
+int main() {
+    try {
+        constexpr int RAW_EVENTS = 2'000'000;
+        constexpr int BUS_EVENTS = 1'000'000;
+        const std::vector<int> producer_counts = {1, 2, 4, 8, 16};
+
+        std::cout << "=== Queue Engine Benchmark ===\n";
+        std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n";
+
+        std::cout << "\n--- Raw rings (events/sec) ---\n";
+        print_header();
+        for (const int producers : producer_counts) {
+            const double cas = run_raw_ring<LockFreeMpscQueue<Event>>(producers, RAW_EVENTS);
+            const double fetch_add = run_raw_ring<FetchAddMpscQueue<Event>>(producers, RAW_EVENTS);
+            const double relaxed = run_raw_ring<RelaxedMpscQueue<Event>>(producers, RAW_EVENTS);
+            print_row(producers, cas, fetch_add, relaxed);
+        }
+
+        std::cout << "\n--- Through EventBus, 1 partition, BLOCK (events/sec) ---\n";
+        print_header();
+        for (const int producers : producer_counts) {
+            const double cas = run_bus(QueueEngine::CAS_RING, producers, BUS_EVENTS);
+            const double fetch_add = run_bus(QueueEngine::FETCH_ADD_RING, producers, BUS_EVENTS);
+            const double relaxed = run_bus(QueueEngine::RELAXED_RING, producers, BUS_EVENTS);
+            print_row(producers, cas, fetch_add, relaxed);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include "event_bus.hpp"
+#include "replication.hpp"
+
+using namespace eventbus;
+using namespace std::chrono_literals;
+
+/**
+ * Replication Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - What mirroring a topic to a hot standby costs producers: one more ring to enqueue into, the rest happens on the
+ *   ReplicationSender thread
+ * - How far the standby trails the primary once publishing stops
+ * - Whether a standby that takes over hands the consumer exactly the events it had not consumed yet
+ *
+ * TESTING SETUP:
+ * One producer publishes EVENTS events, keyed over KEYS keys, into one topic with PARTITIONS partitions and BLOCK
+ * back-pressure. One consumer thread consumes the first CONSUMED_BEFORE_FAILOVER of them on the primary meanwhile. The standby runs in
+ * the same process and is reached over loopback TCP, as a second process on the same host would be.
+ * - plain: topic not replicated
+ * - replicated: TopicConfig::replicated with a StandbyReplica attached, taken over by a fresh bus at the end
+ *
+ * KEY METRICS MEASURED:
+ * - Producer nanoseconds per event
+ * - Catch-up: time from the last publish until the standby acknowledged every frame sent
+ * - Events the consumer got from the standby's bus after the takeover
+ */
+
+constexpr size_t PARTITIONS = 8;
+constexpr int EVENTS = 200000;
+constexpr int KEYS = 64;
+constexpr size_t CONSUMED_BEFORE_FAILOVER = EVENTS / 2;
+
+struct Result {
+    double producer_ns_per_event = 0;
+    double catch_up_ms = 0;
+    size_t recovered = 0;
+};
+
+EventBusConfig make_config(const bool replicated) {
+    TopicConfig topic;
+    topic.name = "orders";
+    topic.partition_count = PARTITIONS;
+    topic.queue_capacity = 32768; // holds what is left unconsumed
+    topic.replicated = replicated;
+    ConsumerGroupConfig group;
+    group.group_id = "matchers";
+    group.topic_name = "orders";
+    group.consumer_count = 1;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back(group);
+    return config;
+}
+
+Result run(const bool replicated) {
+    BackPressureConfig back_pressure;
+    back_pressure.strategy = BackPressureStrategy::BLOCK;
+    EventBus event_bus(make_config(replicated), back_pressure);
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("matchers")[0];
+    std::unique_ptr<StandbyReplica> standby;
+    std::unique_ptr<ReplicationSender> sender;
+    if (replicated) {
+        standby = std::make_unique<StandbyReplica>();
+        ReplicationConfig replication_config;
+        replication_config.port = standby->port();
+        sender = std::make_unique<ReplicationSender>(event_bus, replication_config);
+    }
+
+    std::vector<std::string> keys;
+    for (int k = 0; k < KEYS; ++k) {
+        keys.push_back("instrument-" + std::to_string(k));
+    }
+
+    Result result;
+    std::thread consumer_thread([&] {
+        size_t consumed = 0;
+        while (consumed < CONSUMED_BEFORE_FAILOVER) {
+            consumed += consumer.poll_batch(CONSUMED_BEFORE_FAILOVER - consumed).size();
+        }
+    });
+    const auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < EVENTS; ++i) {
+        event_bus.publish_event(Event("orders", R"({"side":"buy","qty":100,"px":10125})"), keys[i % KEYS]);
+    }
+    const auto published_time = std::chrono::steady_clock::now();
+    result.producer_ns_per_event = std::chrono::duration<double, std::nano>(published_time - start_time).count() /
+        EVENTS;
+    consumer_thread.join();
+    if (!replicated) {
+        return result;
+    }
+
+    const auto deadline = published_time + 30s;
+    while (std::chrono::steady_clock::now() < deadline &&
+           (sender->sent_events() < static_cast<size_t>(EVENTS) || sender->acknowledged_frames() < sender->sent_frames())) {
+        std::this_thread::sleep_for(100us);
+    }
+    result.catch_up_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - published_time).count();
+    sender.reset(); // the primary goes away with its cursors replicated
+
+    EventBus standby_bus(make_config(true), back_pressure);
+    standby->take_over(standby_bus);
+    Consumer& standby_consumer = *standby_bus.consumers_by_consumer_group_id().at("matchers")[0];
+    for (size_t received = 1; received != 0; result.recovered += received) {
+        received = standby_consumer.poll_batch(4096).size();
+    }
+    return result;
+}
+
+int main() {
+    try {
+        std::cout << "=== Replication Benchmark ===\n";
+        std::cout << EVENTS << " events over " << PARTITIONS << " partitions, " << CONSUMED_BEFORE_FAILOVER
+                  << " consumed on the primary before failing over\n\n";
+        std::cout << std::setw(12) << "mode" << std::setw(16) << "ns per event" << std::setw(16) << "catch-up ms"
+                  << std::setw(12) << "recovered" << "\n";
+        for (const bool replicated : {false, true}) {
+            const Result result = run(replicated);
+            std::cout << std::setw(12) << (replicated ? "replicated" : "plain") << std::fixed << std::setprecision(1)
+                      << std::setw(16) << result.producer_ns_per_event;
+            if (replicated) {
+                std::cout << std::setw(16) << result.catch_up_ms << std::setw(12) << result.recovered;
+            }
+            std::cout << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
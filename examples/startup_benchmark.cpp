@@ -0,0 +1,111 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include "event_bus.hpp"
+
+using namespace eventbus;
+
+/**
+ * Startup Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - How long EventBus construction takes for a very large topology (10k topics, several groups each)
+ * - How much building the partition rings on several threads (EventBusConfig::startup_threads) saves
+ * - What allocating rings on first use (TopicConfig::allocate_queues_on_first_use) leaves of startup
+ *
+ * TESTING SETUP:
+ * TOPICS topics with PARTITIONS partitions and GROUPS consumer groups of 1 consumer each, every ring RING_CAPACITY
+ * slots. Defaults are 10000 topics x 4 groups x 1 partition x 256 slots, about 1GB of rings, override them with
+ *   startup_benchmark [topics] [groups] [partitions] [ring_capacity]
+ * Every configuration is built and torn down REPEATS times, the fastest construction is reported.
+ *
+ * KEY METRICS MEASURED:
+ * - Construction time in milliseconds per startup thread count, eager and lazy rings
+ * - Speedup against a single startup thread
+ *
+ * The speedup is bounded by the core count and by how fast the allocator hands out fresh pages.
+ */
+
+struct Topology {
+    size_t topics;
+    size_t groups;
+    size_t partitions;
+    size_t ring_capacity;
+};
+
+EventBusConfig make_config(const Topology& topology, const size_t startup_threads, const bool lazy) {
+    EventBusConfig config;
+    config.startup_threads = startup_threads;
+    config.topics.reserve(topology.topics);
+    config.consumer_groups.reserve(topology.topics * topology.groups);
+    for (size_t t = 0; t < topology.topics; ++t) {
+        TopicConfig topic{"topic_" + std::to_string(t), topology.partitions, topology.ring_capacity};
+        topic.allocate_queues_on_first_use = lazy;
+        config.topics.push_back(topic);
+        for (size_t g = 0; g < topology.groups; ++g) {
+            config.consumer_groups.push_back({topic.name + "_group_" + std::to_string(g), topic.name, 1});
+        }
+    }
+    return config;
+}
+
+double construction_ms(const EventBusConfig& config) {
+    constexpr int REPEATS = 3;
+    double best = 0;
+    for (int i = 0; i < REPEATS; ++i) {
+        const auto start_time = std::chrono::steady_clock::now();
+        {
+            const EventBus event_bus(config);
+            const auto end_time = std::chrono::steady_clock::now();
+            const double ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+            best = i == 0 || ms < best ? ms : best;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Topology topology{10000, 4, 1, 256};
+        size_t* fields[] = {&topology.topics, &topology.groups, &topology.partitions, &topology.ring_capacity};
+        for (int i = 1; i < argc && i <= 4; ++i) {
+            *fields[i - 1] = std::stoul(argv[i]);
+        }
+
+        const size_t hardware_threads = std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 1;
+        std::vector<size_t> thread_counts = {1};
+        for (size_t threads = 2; threads < hardware_threads; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        if (hardware_threads > 1) {
+            thread_counts.push_back(hardware_threads);
+        }
+
+        std::cout << "=== Startup Benchmark ===\n";
+        std::cout << "Hardware threads: " << hardware_threads << "\n";
+        std::cout << topology.topics << " topics x " << topology.groups << " groups x " << topology.partitions
+                  << " partitions, " << topology.ring_capacity << " slots per ring\n\n";
+
+        std::cout << std::setw(10) << "threads" << std::setw(20) << "eager rings (ms)" << std::setw(20) << "lazy rings (ms)" << "\n";
+        double eager_baseline = 0;
+        for (const size_t threads : thread_counts) {
+            const double eager = construction_ms(make_config(topology, threads, false));
+            const double lazy = construction_ms(make_config(topology, threads, true));
+            if (threads == 1) {
+                eager_baseline = eager;
+            }
+            std::cout << std::setw(10) << threads
+                      << std::setw(12) << std::fixed << std::setprecision(1) << eager
+                      << " (" << std::setprecision(2) << (eager > 0 ? eager_baseline / eager : 0.0) << "x)"
+                      << std::setw(20) << std::setprecision(1) << lazy << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
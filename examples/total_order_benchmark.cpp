@@ -0,0 +1,138 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include "event_bus.hpp"
+
+using namespace eventbus;
+using namespace std::chrono_literals;
+
+/**
+ * Total Order Benchmark
+ *
+ * WHAT WE ARE TESTING:
+ * - What stamping a topic wide sequence costs producers, one reservation per event (publish_event) against one per
+ *   flush (Publisher)
+ * - Whether a MergeOrder::SEQUENCE consumer gets the events of all partitions back in publish order
+ *
+ * TESTING SETUP:
+ * PRODUCERS threads publish EVENTS_PER_PRODUCER events each, keyed over KEYS keys, into one topic with PARTITIONS
+ * partitions and BLOCK back-pressure, so nothing is dropped. One consumer reads every partition.
+ * - plain: no sequencing, publish_event, poll_batch
+ * - sequenced: total_order topic, publish_event, poll_merged_batch with MergeOrder::SEQUENCE
+ * - sequenced + Publisher: the same, publishing through one coalescing Publisher per thread
+ *
+ * KEY METRICS MEASURED:
+ * - Producer nanoseconds per event, all producers together
+ * - Events the consumer got out of order: by message id for plain, by sequence otherwise
+ */
+
+constexpr size_t PARTITIONS = 8;
+constexpr size_t PRODUCERS = 2;
+constexpr int EVENTS_PER_PRODUCER = 500000;
+constexpr int KEYS = 64;
+
+enum class Mode { PLAIN, SEQUENCED, SEQUENCED_PUBLISHER };
+
+struct Result {
+    double producer_ns_per_event = 0;
+    size_t received = 0;
+    size_t out_of_order = 0;
+};
+
+Result run(const Mode mode) {
+    TopicConfig topic;
+    topic.name = "audit";
+    topic.partition_count = PARTITIONS;
+    topic.queue_capacity = 16384;
+    topic.total_order = mode != Mode::PLAIN;
+    ConsumerGroupConfig group;
+    group.group_id = "auditors";
+    group.topic_name = "audit";
+    group.consumer_count = 1;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back(group);
+    BackPressureConfig back_pressure;
+    back_pressure.strategy = BackPressureStrategy::BLOCK;
+    EventBus event_bus(config, back_pressure);
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("auditors")[0];
+    if (mode != Mode::PLAIN) {
+        MergeConfig merge_config;
+        merge_config.lookahead = 256;
+        merge_config.max_skew = 50ms;
+        merge_config.order = MergeOrder::SEQUENCE;
+        consumer.set_merge_ordering(merge_config);
+    }
+
+    std::vector<std::string> keys;
+    for (int k = 0; k < KEYS; ++k) {
+        keys.push_back("account-" + std::to_string(k));
+    }
+    const size_t total_events = PRODUCERS * EVENTS_PER_PRODUCER;
+
+    Result result;
+    std::thread consumer_thread([&] {
+        size_t last = 0;
+        const auto deadline = std::chrono::steady_clock::now() + 60s;
+        while (result.received < total_events && std::chrono::steady_clock::now() < deadline) {
+            const auto& batch = mode == Mode::PLAIN ? consumer.poll_batch(256) : consumer.poll_merged_batch(256);
+            for (const auto& event : batch) {
+                if (mode == Mode::PLAIN) {
+                    result.out_of_order += event.id < last ? 1 : 0; // ids are taken in publish order as well
+                    last = event.id;
+                } else {
+                    result.out_of_order += event.sequence != last + 1 ? 1 : 0;
+                    last = event.sequence;
+                }
+            }
+            result.received += batch.size();
+        }
+    });
+
+    const auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            if (mode == Mode::SEQUENCED_PUBLISHER) {
+                Publisher publisher(event_bus);
+                for (int i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                    publisher.publish(Event("audit", R"({"op":"debit","amount":125})"), keys[(p * 7 + i) % KEYS]);
+                }
+                return;
+            }
+            for (int i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                event_bus.publish_event(Event("audit", R"({"op":"debit","amount":125})"), keys[(p * 7 + i) % KEYS]);
+            }
+        });
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    result.producer_ns_per_event = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start_time).count() / static_cast<double>(total_events);
+    consumer_thread.join();
+    return result;
+}
+
+int main() {
+    try {
+        std::cout << "=== Total Order Benchmark ===\n";
+        std::cout << PRODUCERS << " producers x " << EVENTS_PER_PRODUCER << " events over " << PARTITIONS
+                  << " partitions, one consumer reading all of them\n\n";
+        std::cout << std::setw(24) << "mode" << std::setw(16) << "ns per event" << std::setw(12) << "received"
+                  << std::setw(16) << "out of order" << "\n";
+        for (const Mode mode : {Mode::PLAIN, Mode::SEQUENCED, Mode::SEQUENCED_PUBLISHER}) {
+            const Result result = run(mode);
+            std::cout << std::setw(24) << (mode == Mode::PLAIN ? "plain" : mode == Mode::SEQUENCED ? "sequenced" : "sequenced + Publisher")
+                      << std::fixed << std::setprecision(1) << std::setw(16) << result.producer_ns_per_event
+                      << std::setw(12) << result.received << std::setw(16) << result.out_of_order << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
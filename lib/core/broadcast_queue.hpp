@@ -0,0 +1,250 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "prefetch.hpp"
+
+namespace eventbus {
+    // Multi producer ring read in full by a fixed set of readers, each through a cursor of its own.
+    // Producers claim slots with a CAS on the tail like LockFreeMpscQueue. A slot is free again once the slowest
+    // reader moved past it, so instead of a per slot release the producers gate on the minimum reader cursor.
+    // That minimum is cached and only recomputed when the cached value says the ring is full.
+    // Readers copy items out, they never move them: every other reader still has to see the slot.
+    // Each reader index must only ever be used by one thread at a time.
+    template<typename T>
+    class BroadcastQueue {
+    public:
+        BroadcastQueue(const size_t capacity, const size_t reader_count)
+               : capacity_(capacity),
+                 reader_count_(reader_count),
+                 buffer_(std::make_unique<node_[]>(capacity_)),
+                 readers_(std::make_unique<reader_cursor_[]>(reader_count_)),
+                 tail_(0),
+                 gate_(0) {
+            for (size_t i = 0; i < capacity_; ++i) {
+                buffer_[i].seq_.store(i, std::memory_order_relaxed); // anything but i + 1, which means published
+            }
+        }
+
+        bool enqueue(const T& item) {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            while (true) {
+                if (pos & CLOSED_BIT) {
+                    return false; // queue was retired, see close()
+                }
+                if (free_slots(pos) == 0) {
+                    return false;
+                }
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+                    node_& node = buffer_[pos & (capacity_ - 1)];
+                    node.item_ = item;
+                    node.seq_.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                // CAS failed, pos was updated to current tail value, retry
+            }
+        }
+
+        // Claims up to count consecutive slots with a single CAS and returns how many items were enqueued,
+        // 0 when the queue is full or closed
+        size_t enqueue_batch(const T* items, const size_t count) {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            while (count != 0) {
+                if (pos & CLOSED_BIT) {
+                    return 0;
+                }
+                const size_t free = free_slots(pos);
+                if (free == 0) {
+                    return 0;
+                }
+                const size_t batch = count < free ? count : free;
+                if (tail_.compare_exchange_weak(pos, pos + batch,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+                    for (size_t i = 0; i < batch; ++i) {
+                        node_& node = buffer_[(pos + i) & (capacity_ - 1)];
+                        node.item_ = items[i];
+                        node.seq_.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return batch;
+                }
+            }
+            return 0;
+        }
+
+        bool dequeue(const size_t reader, T& item) {
+            std::atomic<size_t>& cursor = readers_[reader].position_;
+            const size_t pos = cursor.load(std::memory_order_relaxed);
+            const node_& node = buffer_[pos & (capacity_ - 1)];
+            if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                return false; // No data ready for this position
+            }
+            item = node.item_;
+            cursor.store(pos + 1, std::memory_order_release); // after the copy, producers may reuse the slot
+            return true;
+        }
+
+        // Copies up to max_items into out for one reader, oldest first, prefetching like
+        // LockFreeMpscQueue::dequeue_batch. The reader cursor is published once per call.
+        size_t dequeue_batch(const size_t reader, std::vector<T>& out, const size_t max_items, const size_t prefetch_distance) {
+            std::atomic<size_t>& cursor = readers_[reader].position_;
+            size_t pos = cursor.load(std::memory_order_relaxed);
+            const size_t start = pos;
+            const size_t heap_distance = prefetch_distance / 2;
+            while (pos - start < max_items) {
+                if (prefetch_distance != 0) {
+                    const node_& slot = buffer_[(pos + prefetch_distance) & (capacity_ - 1)];
+                    prefetch_for_read(&slot.item_);
+                    prefetch_for_read(&slot.seq_);
+                    const node_& ahead = buffer_[(pos + heap_distance) & (capacity_ - 1)];
+                    if (ahead.seq_.load(std::memory_order_acquire) == pos + heap_distance + 1) {
+                        prefetch_item_heap(ahead.item_);
+                    }
+                }
+                const node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                out.push_back(node.item_);
+                ++pos;
+            }
+            if (pos != start) {
+                cursor.store(pos, std::memory_order_release);
+            }
+            return pos - start;
+        }
+
+        // Moves one reader's cursor over up to count published slots without copying them out, visiting each, and
+        // returns how many it passed. For readers that only track progress, like the commit cursor of an
+        // acknowledged lane: as long as they lag, producers keep off the slots for every other reader.
+        template<typename Visitor>
+        size_t skip(const size_t reader, const size_t count, Visitor&& visitor) {
+            std::atomic<size_t>& cursor = readers_[reader].position_;
+            const size_t start = cursor.load(std::memory_order_relaxed);
+            size_t pos = start;
+            while (pos - start < count) {
+                const node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                visitor(node.item_);
+                ++pos;
+            }
+            if (pos != start) {
+                cursor.store(pos, std::memory_order_release);
+            }
+            return pos - start;
+        }
+
+        // Moves one reader's cursor back, it reads the slots from position on again. Only while the cursor of
+        // another reader is at or before position, which is what keeps producers off those slots.
+        void rewind(const size_t reader, const size_t position) {
+            readers_[reader].position_.store(position, std::memory_order_release);
+        }
+
+        // Visits what one reader has not read yet, oldest first. Producers and readers must be quiesced.
+        template<typename Visitor>
+        void for_each_pending(const size_t reader, Visitor&& visitor) const {
+            const size_t tail = tail_.load(std::memory_order_acquire) & ~CLOSED_BIT;
+            for (size_t pos = head_position(reader); pos != tail; ++pos) {
+                const node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break; // slot claimed but not written yet
+                }
+                visitor(node.item_);
+            }
+        }
+
+        // Cursor of one reader, i.e. how many events it has read from this queue
+        [[nodiscard]] size_t head_position(const size_t reader) const {
+            return readers_[reader].position_.load(std::memory_order_acquire);
+        }
+
+        // Producer cursor, i.e. how many slots were ever claimed. Claimed slots are always written eventually.
+        [[nodiscard]] size_t tail_position() const {
+            return tail_.load(std::memory_order_acquire) & ~CLOSED_BIT;
+        }
+
+        // Stops all further enqueues, producers that already claimed a slot still complete their write
+        void close() {
+            tail_.fetch_or(CLOSED_BIT, std::memory_order_acq_rel);
+        }
+
+        [[nodiscard]] bool is_closed() const {
+            return (tail_.load(std::memory_order_acquire) & CLOSED_BIT) != 0;
+        }
+
+        // A closed queue is drained for a reader once that reader caught up with the last claimed slot
+        [[nodiscard]] bool is_drained(const size_t reader) const {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            return (tail & CLOSED_BIT) != 0 && head_position(reader) == (tail & ~CLOSED_BIT);
+        }
+
+        // Claimed but not yet read slots of one reader, a racy estimate meant for sizing decisions
+        [[nodiscard]] size_t size_approx(const size_t reader) const {
+            const size_t head = readers_[reader].position_.load(std::memory_order_relaxed);
+            const size_t tail = tail_.load(std::memory_order_relaxed) & ~CLOSED_BIT;
+            return tail > head ? tail - head : 0;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return capacity_;
+        }
+
+        [[nodiscard]] size_t reader_count() const {
+            return reader_count_;
+        }
+
+        // Bytes held by the slot array itself, the reader cursors are a few lines on top whatever the capacity
+        static constexpr size_t memory_bytes_for_capacity(const size_t capacity) {
+            return capacity * sizeof(node_);
+        }
+
+    private:
+        static constexpr size_t CLOSED_BIT = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+        // Slots a producer at pos may claim. Reader cursors only move forward, so a stale gate can only
+        // under-report what is free, never hand out a slot some reader still has to see.
+        // A pos older than some reader cursor is a stale tail, the CAS on it fails whatever this returns.
+        size_t free_slots(const size_t pos) {
+            size_t used = pos - gate_.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(used) < 0) {
+                return capacity_;
+            }
+            if (used < capacity_) {
+                return capacity_ - used;
+            }
+            size_t slowest = readers_[0].position_.load(std::memory_order_acquire);
+            for (size_t reader = 1; reader < reader_count_; ++reader) {
+                const size_t position = readers_[reader].position_.load(std::memory_order_acquire);
+                slowest = position < slowest ? position : slowest;
+            }
+            gate_.store(slowest, std::memory_order_release); // racing producers may store an older value, still safe
+            used = pos - slowest;
+            if (static_cast<intptr_t>(used) < 0) {
+                return capacity_;
+            }
+            return used < capacity_ ? capacity_ - used : 0;
+        }
+
+        struct node_ {
+            T item_;
+            std::atomic<size_t> seq_;
+        };
+
+        struct alignas(64) reader_cursor_ {
+            std::atomic<size_t> position_{0};
+        };
+
+        size_t capacity_;
+        size_t reader_count_;
+        std::unique_ptr<node_[]> buffer_;
+        std::unique_ptr<reader_cursor_[]> readers_;
+        alignas(64) std::atomic<size_t> tail_;
+        alignas(64) std::atomic<size_t> gate_; // cached slowest reader cursor, written by producers only
+    };
+}
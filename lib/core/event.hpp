@@ -1,17 +1,30 @@
 #pragma once
+#include <chrono>
 #include <string>
 #include <utility>
 
+#include "prefetch.hpp"
+
 namespace eventbus {
     struct Event {
         std::string topic;
         std::string payload;
         mutable std::size_t id{};
+        mutable std::size_t key_hash{}; // hash of the partition key, NO_KEY when published without one
+        mutable std::size_t sequence{}; // topic wide publish order of a total order topic, NO_SEQUENCE otherwise
         std::chrono::steady_clock::time_point timestamp;
 
+        static constexpr std::size_t NO_KEY = 0;
+        static constexpr std::size_t NO_SEQUENCE = 0;
+
         Event () = default;
 
         Event(std::string topic, std::string payload): topic(std::move(topic)), payload(std::move(payload)),
                                                        timestamp(std::chrono::steady_clock::now()) {}
     };
+
+    // Payloads above the small string buffer live on the heap, a separate miss per event when draining a backlog
+    inline void prefetch_item_heap(const Event& event) {
+        prefetch_for_read(event.payload.data());
+    }
 }
@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "event.hpp"
+#include "lz_block_codec.hpp"
+
+namespace eventbus {
+    // Binary batch format used wherever events leave the in-memory rings (history, snapshots, bridges).
+    // Compression is applied to a whole batch, never to a single event, so the publish path never pays for it.
+    //
+    // Frame: [magic u32][flags u8][event count u32][raw body size u32][stored body size u32][body]
+    // Event in body: [topic len u32][topic][payload len u32][payload][id u64][timestamp ns i64][key hash u64][sequence u64]
+    // The key hash is only present when FLAG_KEY_HASHES is set, the sequence when FLAG_SEQUENCES is set. Frames
+    // written before those existed decode with NO_KEY and NO_SEQUENCE.
+    // Timestamps are steady_clock readings in memory, which mean nothing in another process or after a reboot. Frames
+    // carry them as wall clock ns since the Unix epoch (FLAG_WALL_CLOCK_TIMESTAMPS) and decoding maps them back onto
+    // the local steady_clock, so they keep their age as far as the two wall clocks agree. Older frames held raw
+    // steady ticks, their timestamps are dropped and decode as a default time_point, older than any live event.
+    // All integers are little endian.
+    class EventBatchCodec {
+    public:
+        static constexpr uint32_t FRAME_MAGIC = 0x31425645; // "EVB1"
+        static constexpr uint8_t FLAG_COMPRESSED = 0x01;
+        static constexpr uint8_t FLAG_KEY_HASHES = 0x02;
+        static constexpr uint8_t FLAG_SEQUENCES = 0x04;
+        static constexpr uint8_t FLAG_WALL_CLOCK_TIMESTAMPS = 0x08;
+        static constexpr size_t FRAME_HEADER_SIZE = 4 + 1 + 4 + 4 + 4;
+        static constexpr size_t MIN_EVENT_SIZE = 4 + 4 + 8 + 8; // empty topic and payload, no optional fields
+
+        // Appends one frame holding all events to out. Compression is kept only when it actually shrinks the body.
+        static void encode(const std::vector<Event>& events, std::string& out, const bool compress = true) {
+            const std::chrono::nanoseconds wall_clock_offset = steady_to_wall_clock_offset();
+            std::string raw_body;
+            raw_body.reserve(events.size() * 64);
+            for (const auto& event : events) {
+                put_u32(raw_body, static_cast<uint32_t>(event.topic.size()));
+                raw_body.append(event.topic);
+                put_u32(raw_body, static_cast<uint32_t>(event.payload.size()));
+                raw_body.append(event.payload);
+                put_u64(raw_body, event.id);
+                put_u64(raw_body, static_cast<uint64_t>((std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    event.timestamp.time_since_epoch()) + wall_clock_offset).count()));
+                put_u64(raw_body, event.key_hash);
+                put_u64(raw_body, event.sequence);
+            }
+
+            if (raw_body.size() > LzBlockCodec::MAX_BLOCK_SIZE) {
+                throw std::runtime_error("Event batch of " + std::to_string(events.size()) + " events is too large for one frame");
+            }
+
+            uint8_t flags = FLAG_KEY_HASHES | FLAG_SEQUENCES | FLAG_WALL_CLOCK_TIMESTAMPS;
+            std::string compressed_body;
+            if (compress) {
+                compressed_body.reserve(LzBlockCodec::max_compressed_size(raw_body.size()));
+                LzBlockCodec::compress(raw_body.data(), raw_body.size(), compressed_body);
+                if (compressed_body.size() < raw_body.size()) {
+                    flags |= FLAG_COMPRESSED;
+                }
+            }
+            const std::string& body = (flags & FLAG_COMPRESSED) ? compressed_body : raw_body;
+
+            put_u32(out, FRAME_MAGIC);
+            out.push_back(static_cast<char>(flags));
+            put_u32(out, static_cast<uint32_t>(events.size()));
+            put_u32(out, static_cast<uint32_t>(raw_body.size()));
+            put_u32(out, static_cast<uint32_t>(body.size()));
+            out.append(body);
+        }
+
+        // Decodes one frame starting at data and appends its events to out. Returns the number of bytes consumed
+        // so a stream of frames can be decoded back to back.
+        static size_t decode(const char* data, const size_t size, std::vector<Event>& out) {
+            if (size < FRAME_HEADER_SIZE) {
+                throw std::runtime_error("Truncated event batch header");
+            }
+            size_t pos = 0;
+            if (get_u32(data, pos) != FRAME_MAGIC) {
+                throw std::runtime_error("Invalid event batch magic");
+            }
+            const uint8_t flags = static_cast<uint8_t>(data[pos++]);
+            const uint32_t event_count = get_u32(data, pos);
+            const uint32_t raw_size = get_u32(data, pos);
+            const uint32_t stored_size = get_u32(data, pos);
+            if (stored_size > size - pos) {
+                throw std::runtime_error("Truncated event batch body");
+            }
+
+            std::string decompressed_body;
+            const char* body = data + pos;
+            size_t body_size = stored_size;
+            if (flags & FLAG_COMPRESSED) {
+                LzBlockCodec::decompress(body, stored_size, raw_size, decompressed_body);
+                body = decompressed_body.data();
+                body_size = decompressed_body.size();
+            }
+
+            const std::chrono::nanoseconds wall_clock_offset = steady_to_wall_clock_offset();
+            // The count comes from the frame, only trust it as far as the body can hold that many events
+            out.reserve(out.size() + std::min<size_t>(event_count, body_size / MIN_EVENT_SIZE));
+            size_t body_pos = 0;
+            for (uint32_t i = 0; i < event_count; ++i) {
+                Event event;
+                event.topic = get_string(body, body_size, body_pos);
+                event.payload = get_string(body, body_size, body_pos);
+                require(body_size, body_pos, 16);
+                event.id = get_u64(body, body_pos);
+                const std::chrono::nanoseconds wall_clock(static_cast<int64_t>(get_u64(body, body_pos)));
+                if (flags & FLAG_WALL_CLOCK_TIMESTAMPS) {
+                    event.timestamp = std::chrono::steady_clock::time_point(std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration>(wall_clock - wall_clock_offset));
+                }
+                if (flags & FLAG_KEY_HASHES) {
+                    require(body_size, body_pos, 8);
+                    event.key_hash = get_u64(body, body_pos);
+                }
+                if (flags & FLAG_SEQUENCES) {
+                    require(body_size, body_pos, 8);
+                    event.sequence = get_u64(body, body_pos);
+                }
+                out.push_back(std::move(event));
+            }
+            return pos + stored_size;
+        }
+
+        static void put_u32(std::string& out, const uint32_t value) {
+            for (int i = 0; i < 4; ++i) {
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        static void put_u64(std::string& out, const uint64_t value) {
+            for (int i = 0; i < 8; ++i) {
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        static uint32_t get_u32(const char* data, size_t& pos) {
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) {
+                value |= static_cast<uint32_t>(static_cast<uint8_t>(data[pos++])) << (8 * i);
+            }
+            return value;
+        }
+
+        static uint64_t get_u64(const char* data, size_t& pos) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos++])) << (8 * i);
+            }
+            return value;
+        }
+
+    private:
+        // What to add to a steady_clock reading to get wall clock ns since the Unix epoch, taken once per frame
+        static std::chrono::nanoseconds steady_to_wall_clock_offset() {
+            const auto wall_now = std::chrono::system_clock::now();
+            const auto steady_now = std::chrono::steady_clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(wall_now.time_since_epoch())
+                 - std::chrono::duration_cast<std::chrono::nanoseconds>(steady_now.time_since_epoch());
+        }
+
+        static void require(const size_t size, const size_t pos, const size_t needed) {
+            if (needed > size - pos) {
+                throw std::runtime_error("Truncated event in batch body");
+            }
+        }
+
+        static std::string get_string(const char* body, const size_t body_size, size_t& pos) {
+            require(body_size, pos, 4);
+            const uint32_t length = get_u32(body, pos);
+            require(body_size, pos, length);
+            std::string value(body + pos, length);
+            pos += length;
+            return value;
+        }
+    };
+}
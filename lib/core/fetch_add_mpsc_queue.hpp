@@ -0,0 +1,225 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "prefetch.hpp"
+#include <thread>
+
+using std::atomic;
+
+namespace eventbus {
+    // Ticketed ring for topics with many producers. LockFreeMpscQueue claims a slot with a CAS on tail_, and under
+    // contention most of those CAS attempts fail and go around again. Here the ticket is a fetch_add that always
+    // succeeds, and the only CAS left is on the free space count, which producers only contend on while taking it:
+    //   1. take one unit of free space from free_slots_, never driving it below zero, so a full ring turns producers
+    //      away without a transient deficit that would make others see a full ring too
+    //   2. take a ticket from tail_, the ticket is the producer's slot
+    //   3. write the item and publish it through the slot sequence like LockFreeMpscQueue does
+    // Admission in step 1 guarantees the consumer has already released the slot a ticket maps to, so step 3 never
+    // waits on the consumer, at most on the release store becoming visible.
+    // Same consumer side, close() and capacity rules as LockFreeMpscQueue so both can back a partition lane.
+    template<typename T>
+    class FetchAddMpscQueue {
+
+    public:
+        explicit FetchAddMpscQueue(const size_t capacity)
+               : capacity_(capacity),
+                 buffer_(std::make_unique<node_[]>(capacity_)),
+                 head_(0),
+                 free_slots_(static_cast<int64_t>(capacity_)),
+                 tail_(0) {
+            for (size_t i = 0; i < capacity_; ++i) {
+                buffer_[i].seq_.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool enqueue(const T& item) {
+            if (claim_free_slots(1) == 0) {
+                return false; // full, or closed
+            }
+            const size_t pos = tail_.fetch_add(1, std::memory_order_acq_rel);
+            if (pos & CLOSED_BIT) {
+                return false; // retired after we were admitted, the ticket is void and the space is never reused
+            }
+
+            node_& node = buffer_[pos & (capacity_ - 1)];
+            while (node.seq_.load(std::memory_order_acquire) != pos) {
+                std::this_thread::yield(); // the consumer release for this slot is already on its way
+            }
+            node.item_ = item;
+            node.seq_.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Admits as much of the batch as there is free space for, then takes all tickets with one fetch_add.
+        // Returns how many items were enqueued, in batch order.
+        size_t enqueue_batch(const T* items, const size_t count) {
+            if (count == 0) {
+                return 0;
+            }
+            const size_t batch = claim_free_slots(count);
+            if (batch == 0) {
+                return 0;
+            }
+            const size_t pos = tail_.fetch_add(batch, std::memory_order_acq_rel);
+            if (pos & CLOSED_BIT) {
+                return 0;
+            }
+
+            for (size_t i = 0; i < batch; ++i) {
+                node_& node = buffer_[(pos + i) & (capacity_ - 1)];
+                while (node.seq_.load(std::memory_order_acquire) != pos + i) {
+                    std::this_thread::yield();
+                }
+                node.item_ = items[i];
+                node.seq_.store(pos + i + 1, std::memory_order_release);
+            }
+            return batch;
+        }
+
+        bool dequeue(T& item) {
+            const size_t pos = head_.load(std::memory_order_relaxed);
+            node_& node = buffer_[pos & (capacity_ - 1)];
+
+            if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                return false; // No data ready for this position
+            }
+
+            item = node.item_;
+            node.seq_.store(pos + capacity_, std::memory_order_release);
+            head_.store(pos + 1, std::memory_order_relaxed);
+            free_slots_.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        // Drains up to max_items into out, oldest first, and returns how many were taken. While walking the ring it
+        // prefetches the slot prefetch_distance ahead and the heap data of the published item half that distance
+        // ahead, whose slot line was prefetched earlier, so a deep backlog is not drained at memory latency speed.
+        // Items are moved out of their slots and the consumer cursor is published once per call.
+        size_t dequeue_batch(std::vector<T>& out, const size_t max_items, const size_t prefetch_distance) {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            const size_t start = pos;
+            const size_t heap_distance = prefetch_distance / 2;
+            while (pos - start < max_items) {
+                if (prefetch_distance != 0) {
+                    const node_& slot = buffer_[(pos + prefetch_distance) & (capacity_ - 1)];
+                    prefetch_for_read(&slot.item_); // a slot can straddle two lines, the item starts one
+                    prefetch_for_read(&slot.seq_);  // and the sequence usually ends the other
+                    const node_& ahead = buffer_[(pos + heap_distance) & (capacity_ - 1)];
+                    if (ahead.seq_.load(std::memory_order_acquire) == pos + heap_distance + 1) {
+                        prefetch_item_heap(ahead.item_);
+                    }
+                }
+                node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                out.push_back(std::move(node.item_));
+                node.seq_.store(pos + capacity_, std::memory_order_release);
+                ++pos;
+            }
+            head_.store(pos, std::memory_order_relaxed);
+            if (pos != start) {
+                free_slots_.fetch_add(static_cast<int64_t>(pos - start), std::memory_order_release);
+            }
+            return pos - start;
+        }
+
+        // Visits the events that are published but not yet dequeued, oldest first, without consuming them.
+        // Only meaningful while producers and the consumer are quiesced (snapshots on controlled shutdown).
+        template<typename Visitor>
+        void for_each_pending(Visitor&& visitor) const {
+            const size_t tail = claimed_tail();
+            for (size_t pos = head_.load(std::memory_order_acquire); pos != tail; ++pos) {
+                const node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break; // slot claimed but not written yet
+                }
+                visitor(node.item_);
+            }
+        }
+
+        // Consumer cursor, i.e. how many events were ever dequeued from this queue
+        [[nodiscard]] size_t head_position() const {
+            return head_.load(std::memory_order_acquire);
+        }
+
+        // Producer cursor, i.e. how many valid tickets were ever handed out
+        [[nodiscard]] size_t tail_position() const {
+            return claimed_tail();
+        }
+
+        // Stops all further enqueues so the queue can be drained and retired. Control plane only.
+        // Tickets handed out after the close bit is set are void, so the last valid ticket is recorded first.
+        void close() {
+            // Drives free space far negative so new producers are turned away in step 1 already
+            free_slots_.fetch_sub(CLOSED_FREE_SLOTS, std::memory_order_relaxed);
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            do {
+                closed_tail_.store(tail, std::memory_order_relaxed);
+            } while (!tail_.compare_exchange_weak(tail, tail | CLOSED_BIT,
+                                                  std::memory_order_acq_rel, std::memory_order_relaxed));
+        }
+
+        [[nodiscard]] bool is_closed() const {
+            return (tail_.load(std::memory_order_acquire) & CLOSED_BIT) != 0;
+        }
+
+        // A closed queue is drained once the consumer has caught up with the last valid ticket
+        [[nodiscard]] bool is_drained() const {
+            return is_closed() && head_.load(std::memory_order_relaxed) == closed_tail_.load(std::memory_order_relaxed);
+        }
+
+        // Claimed but not yet dequeued slots, a racy estimate meant for sizing decisions
+        [[nodiscard]] size_t size_approx() const {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t tail = claimed_tail();
+            return tail > head ? tail - head : 0;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return capacity_;
+        }
+
+        // Bytes held by the slot array itself, excluding anything the items own on the heap
+        static constexpr size_t memory_bytes_for_capacity(const size_t capacity) {
+            return capacity * sizeof(node_);
+        }
+
+    private:
+        static constexpr size_t CLOSED_BIT = size_t{1} << (sizeof(size_t) * 8 - 1);
+        static constexpr int64_t CLOSED_FREE_SLOTS = int64_t{1} << 62;
+
+        // Takes up to wanted units of free space and returns how many it got. A closed queue has far negative space.
+        size_t claim_free_slots(const size_t wanted) {
+            int64_t free = free_slots_.load(std::memory_order_relaxed);
+            int64_t taken = 0;
+            do {
+                if (free <= 0) {
+                    return 0;
+                }
+                taken = free < static_cast<int64_t>(wanted) ? free : static_cast<int64_t>(wanted);
+            } while (!free_slots_.compare_exchange_weak(free, free - taken,
+                                                        std::memory_order_acquire, std::memory_order_relaxed));
+            return static_cast<size_t>(taken);
+        }
+
+        [[nodiscard]] size_t claimed_tail() const {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            return (tail & CLOSED_BIT) ? closed_tail_.load(std::memory_order_relaxed) : tail;
+        }
+
+        struct node_ {
+            T item_;
+            std::atomic<size_t> seq_;
+        };
+        size_t capacity_;
+        std::unique_ptr<node_[]> buffer_;
+        alignas(64) atomic<size_t> head_;
+        alignas(64) atomic<int64_t> free_slots_;
+        alignas(64) atomic<size_t> tail_;
+        atomic<size_t> closed_tail_{0}; // last valid ticket + 1, written before the close bit becomes visible
+    };
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eventbus {
+    // Lets a control plane writer wait until every reader that may still act on an old value is done, without
+    // readers ever blocking or sharing a cache line. A reader marks itself in the counter set of the current epoch,
+    // on the stripe of its thread. synchronize() flips the epoch and waits for the previous set to drain; a reader
+    // that raced with the flip notices it and re-enters in the new set. Writers are serialized internally.
+    //
+    // Threads alive at the same time get stripes of their own, up to STRIPE_COUNT of them, so entering is two
+    // read-modify-writes on a line no other thread writes. Only threads beyond that share stripes.
+    //
+    // Typical use: publish the new value, synchronize(), then rely on no reader using the old one anymore.
+    // Writers that must not wait stamp what they unpublished with current_epoch() and free it once try_elapse()
+    // on that stamp returns true, polling again later otherwise.
+    //
+    // The epoch only flips once the set before it drained, so with the epoch at e every reader that entered at
+    // e - 2 or earlier is gone.
+    class GracePeriod {
+        struct alignas(64) Stripe {
+            std::atomic<size_t> readers{0};
+        };
+
+    public:
+        class ReadGuard {
+        public:
+            explicit ReadGuard(GracePeriod& grace_period) : stripe_(grace_period.enter()) {
+#ifndef NDEBUG
+                held_guards().push_back(&grace_period);
+                grace_period_ = &grace_period;
+#endif
+            }
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+            ~ReadGuard() {
+#ifndef NDEBUG
+                std::vector<const GracePeriod*>& held = held_guards();
+                held.erase(std::find(held.rbegin(), held.rend(), grace_period_).base() - 1);
+#endif
+                stripe_->readers.fetch_sub(1, std::memory_order_release);
+            }
+
+        private:
+            Stripe* stripe_;
+#ifndef NDEBUG
+            const GracePeriod* grace_period_;
+#endif
+        };
+
+#ifndef NDEBUG
+        // Debug builds only: whether the calling thread is inside a read guard of this grace period. Lets code that
+        // dereferences what a writer may free assert it is guarded.
+        [[nodiscard]] bool is_held_by_this_thread() const {
+            const std::vector<const GracePeriod*>& held = held_guards();
+            return std::find(held.begin(), held.end(), this) != held.end();
+        }
+#endif
+
+        // Returns once every reader that entered before the call has left
+        void synchronize() {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            while (!is_drained(epoch_.load(std::memory_order_seq_cst) + 1)) {
+                std::this_thread::yield(); // a try_elapse() flip whose readers are still inside
+            }
+            const size_t previous_epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+            while (!is_drained(previous_epoch)) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Stamp for something a writer just unpublished, every reader that may still hold it entered at this
+        // epoch or before
+        [[nodiscard]] size_t current_epoch() const {
+            return epoch_.load(std::memory_order_seq_cst);
+        }
+
+        // Non-blocking synchronize(): true once every reader that entered at epoch or before has left. Flips the
+        // epoch along when it can, so a later call succeeds once those readers are done. Also false while another
+        // writer is busy.
+        bool try_elapse(const size_t epoch) {
+            const std::unique_lock<std::mutex> lock(writer_mutex_, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                return false;
+            }
+            size_t current = epoch_.load(std::memory_order_seq_cst);
+            if (current >= epoch + 2) {
+                return true;
+            }
+            if (!is_drained(current + 1)) {
+                return false; // readers of current - 1 still inside, the epoch cannot flip yet
+            }
+            if (current == epoch) {
+                current = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+            }
+            return is_drained(current + 1); // the set of epoch itself
+        }
+
+    private:
+        static constexpr size_t STRIPE_COUNT = 128;
+
+        // Stripe of the calling thread, shared by every grace period. A thread that exits hands its stripe on to
+        // the next thread that starts reading.
+        static size_t stripe_index() {
+            struct StripeLease {
+                size_t index;
+
+                StripeLease() {
+                    std::lock_guard<std::mutex> lock(lease_mutex());
+                    auto& free_indices = free_stripe_indices();
+                    if (free_indices.empty()) {
+                        index = next_stripe_index()++ % STRIPE_COUNT;
+                    } else {
+                        index = free_indices.back();
+                        free_indices.pop_back();
+                    }
+                }
+
+                ~StripeLease() {
+                    std::lock_guard<std::mutex> lock(lease_mutex());
+                    free_stripe_indices().push_back(index);
+                }
+            };
+            thread_local const StripeLease lease;
+            return lease.index;
+        }
+
+        static std::mutex& lease_mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        static std::vector<size_t>& free_stripe_indices() {
+            static std::vector<size_t> free_indices;
+            return free_indices;
+        }
+
+        static size_t& next_stripe_index() {
+            static size_t next = 0;
+            return next;
+        }
+
+        // No reader of epoch's set is inside. Only meaningful for a set the current epoch no longer admits.
+        [[nodiscard]] bool is_drained(const size_t epoch) const {
+            for (const Stripe& stripe : stripes_[epoch & 1]) {
+                if (stripe.readers.load(std::memory_order_seq_cst) != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Stripe* enter() {
+            const size_t index = stripe_index();
+            while (true) {
+                const size_t epoch = epoch_.load(std::memory_order_seq_cst);
+                Stripe& stripe = stripes_[epoch & 1][index];
+                stripe.readers.fetch_add(1, std::memory_order_seq_cst);
+                if (epoch_.load(std::memory_order_seq_cst) == epoch) {
+                    return &stripe;
+                }
+                stripe.readers.fetch_sub(1, std::memory_order_release); // flipped under us, the writer may be waiting
+            }
+        }
+
+#ifndef NDEBUG
+        static std::vector<const GracePeriod*>& held_guards() {
+            thread_local std::vector<const GracePeriod*> held;
+            return held;
+        }
+#endif
+
+        std::atomic<size_t> epoch_{0};
+        std::mutex writer_mutex_;
+        Stripe stripes_[2][STRIPE_COUNT];
+    };
+}
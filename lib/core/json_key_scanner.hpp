@@ -0,0 +1,184 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define EVENTBUS_JSON_SCAN_SSE2 1
+#endif
+
+namespace eventbus {
+    namespace json_scan {
+        // Next '"' or '\\' at or after pos, size when there is none. Inside a string nothing else matters.
+        inline size_t find_quote_or_backslash(const char* data, size_t pos, const size_t size) {
+#ifdef EVENTBUS_JSON_SCAN_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            for (; pos + 16 <= size; pos += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                    _mm_cmpeq_epi8(block, backslash)));
+                if (mask != 0) {
+                    return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+                }
+            }
+#endif
+            for (; pos < size; ++pos) {
+                if (data[pos] == '"' || data[pos] == '\\') {
+                    return pos;
+                }
+            }
+            return size;
+        }
+
+        // Next character outside a string that changes what the scanner looks at: '"', '{', '}', '[' or ']'.
+        // Brackets and braces differ only in bit 0x20, so two compares on (byte | 0x20) cover all four.
+        inline size_t find_structural(const char* data, size_t pos, const size_t size) {
+#ifdef EVENTBUS_JSON_SCAN_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i open = _mm_set1_epi8('{');
+            const __m128i close = _mm_set1_epi8('}');
+            const __m128i case_bit = _mm_set1_epi8(0x20);
+            for (; pos + 16 <= size; pos += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+                const __m128i folded = _mm_or_si128(block, case_bit);
+                const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                    _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)));
+                const int mask = _mm_movemask_epi8(hits);
+                if (mask != 0) {
+                    return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+                }
+            }
+#endif
+            for (; pos < size; ++pos) {
+                const char folded = static_cast<char>(data[pos] | 0x20);
+                if (data[pos] == '"' || folded == '{' || folded == '}') {
+                    return pos;
+                }
+            }
+            return size;
+        }
+
+        // Position of the quote closing the string whose contents start at pos, size if it never closes
+        inline size_t find_string_end(const char* data, size_t pos, const size_t size) {
+            while (true) {
+                pos = find_quote_or_backslash(data, pos, size);
+                if (pos >= size || data[pos] == '"') {
+                    return pos;
+                }
+                pos += 2; // the escaped character, whatever it is
+            }
+        }
+
+        inline size_t skip_whitespace(const char* data, size_t pos, const size_t size) {
+            while (pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r')) {
+                ++pos;
+            }
+            return pos;
+        }
+    }
+
+    // Finds one field of a JSON object without parsing the document: a SIMD scan jumps from one quote, brace or
+    // bracket to the next, string contents are skipped 16 bytes at a time, and only keys directly inside the objects
+    // on the path are compared. The path is a field name, or names joined by '.' for nested objects.
+    // Values that are strings come back as the raw bytes between the quotes, escapes are not decoded. Numbers,
+    // true, false and null come back as written. Objects, arrays, a missing field or malformed JSON find nothing.
+    class JsonKeyScanner {
+    public:
+        explicit JsonKeyScanner(const std::string& path) {
+            size_t start = 0;
+            while (true) {
+                const size_t dot = path.find('.', start);
+                path_.push_back(path.substr(start, dot == std::string::npos ? std::string::npos : dot - start));
+                if (path_.back().empty()) {
+                    throw std::runtime_error("JSON key path - " + path + " has an empty field name");
+                }
+                if (dot == std::string::npos) {
+                    break;
+                }
+                start = dot + 1;
+            }
+        }
+
+        // key views into json
+        bool extract(const std::string_view json, std::string_view& key) const {
+            const char* data = json.data();
+            const size_t size = json.size();
+            size_t depth = 0;   // objects and arrays currently open
+            size_t matched = 0; // path fields matched so far, the scan is inside the object of the last one
+            size_t pos = 0;
+            while ((pos = json_scan::find_structural(data, pos, size)) < size) {
+                const char c = data[pos];
+                if (c == '"') {
+                    const size_t start = pos + 1;
+                    const size_t end = json_scan::find_string_end(data, start, size);
+                    if (end >= size) {
+                        return false;
+                    }
+                    pos = end + 1;
+                    if (depth != matched + 1) {
+                        continue; // a string somewhere the path does not lead
+                    }
+                    const size_t colon = json_scan::skip_whitespace(data, pos, size);
+                    if (colon >= size || data[colon] != ':' || json.substr(start, end - start) != path_[matched]) {
+                        continue; // a value, or another key
+                    }
+                    const size_t value = json_scan::skip_whitespace(data, colon + 1, size);
+                    if (matched + 1 == path_.size()) {
+                        return read_scalar(json, value, key);
+                    }
+                    if (value >= size || data[value] != '{') {
+                        return false;
+                    }
+                    ++matched;
+                    pos = value; // its brace opens the next level
+                } else if (c == '{' || c == '[') {
+                    ++depth;
+                    ++pos;
+                } else {
+                    if (depth == matched + 1) {
+                        return false; // left the object the path had reached without finding the next field
+                    }
+                    --depth;
+                    ++pos;
+                }
+            }
+            return false;
+        }
+
+    private:
+        static bool read_scalar(const std::string_view json, const size_t pos, std::string_view& key) {
+            const char* data = json.data();
+            const size_t size = json.size();
+            if (pos >= size) {
+                return false;
+            }
+            if (data[pos] == '"') {
+                const size_t end = json_scan::find_string_end(data, pos + 1, size);
+                if (end >= size) {
+                    return false;
+                }
+                key = json.substr(pos + 1, end - pos - 1);
+                return true;
+            }
+            if (data[pos] == '{' || data[pos] == '[') {
+                return false;
+            }
+            size_t end = pos;
+            while (end < size && data[end] != ',' && data[end] != '}' && data[end] != ']' && data[end] != ' ' &&
+                   data[end] != '\t' && data[end] != '\n' && data[end] != '\r') {
+                ++end;
+            }
+            if (end == pos) {
+                return false;
+            }
+            key = json.substr(pos, end - pos);
+            return true;
+        }
+
+        std::vector<std::string> path_;
+    };
+}
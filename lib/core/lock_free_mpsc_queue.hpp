@@ -2,6 +2,10 @@
 #include <atomic>
 #include <iostream>
 #include <memory>
+#include <utility>
+#include <vector>
+
+#include "prefetch.hpp"
 
 using std::atomic;
 
@@ -20,9 +24,14 @@ namespace eventbus {
             }
         }
 
-        bool enqueue(const T& item) {
+        // Takes item by copy or by move, a moved from item is only touched once a slot was claimed
+        template<typename Item>
+        bool enqueue(Item&& item) {
             size_t pos = tail_.load(std::memory_order_relaxed);
             while (true) {
+                if (pos & CLOSED_BIT) {
+                    return false; // queue was retired, see close()
+                }
                 size_t slot_index = pos & (capacity_ - 1);
                 node_& node = buffer_[slot_index];
 
@@ -37,7 +46,7 @@ namespace eventbus {
                                                    std::memory_order_acq_rel,
                                                    std::memory_order_relaxed)) {
                         // We successfully claimed the slot - write our data
-                        node.item_ = item;
+                        node.item_ = std::forward<Item>(item);
 
                         // Mark the slot as ready for consumer
                         node.seq_.store(pos + 1, std::memory_order_release);
@@ -54,6 +63,50 @@ namespace eventbus {
             }
         }
 
+        // Claims up to count consecutive slots with a single CAS and returns how many items were enqueued,
+        // 0 when the queue is full or closed. Batch order is kept, the claimed slots are published one by one.
+        size_t enqueue_batch(const T* items, const size_t count) {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            while (count != 0) {
+                if (pos & CLOSED_BIT) {
+                    return 0;
+                }
+                // head_ only moves forward, a stale value makes us claim less, never more than is free
+                const size_t used = pos - head_.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(used) < 0) {
+                    pos = tail_.load(std::memory_order_relaxed); // our tail is older than the head we just read
+                    continue;
+                }
+                if (used >= capacity_) {
+                    return 0;
+                }
+                const size_t batch = count < capacity_ - used ? count : capacity_ - used;
+
+                // Slots are released in order, so the last slot being free means the whole range is free
+                const size_t last_pos = pos + batch - 1;
+                const size_t seq = buffer_[last_pos & (capacity_ - 1)].seq_.load(std::memory_order_acquire);
+                const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(last_pos);
+                if (diff < 0) {
+                    return 0; // consumer release not visible yet, treat as full
+                }
+                if (diff > 0) {
+                    pos = tail_.load(std::memory_order_relaxed); // another producer got ahead
+                    continue;
+                }
+                if (tail_.compare_exchange_weak(pos, pos + batch,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+                    for (size_t i = 0; i < batch; ++i) {
+                        node_& node = buffer_[(pos + i) & (capacity_ - 1)];
+                        node.item_ = items[i];
+                        node.seq_.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return batch;
+                }
+            }
+            return 0;
+        }
+
         bool dequeue(T& item) {
             const size_t pos = head_.load(std::memory_order_relaxed);
             size_t slot_index = pos & (capacity_ - 1);
@@ -73,6 +126,92 @@ namespace eventbus {
             return true;
         }
 
+        // Drains up to max_items into out, oldest first, and returns how many were taken. While walking the ring it
+        // prefetches the slot prefetch_distance ahead and the heap data of the published item half that distance
+        // ahead, whose slot line was prefetched earlier, so a deep backlog is not drained at memory latency speed.
+        // Items are moved out of their slots and the consumer cursor is published once per call.
+        size_t dequeue_batch(std::vector<T>& out, const size_t max_items, const size_t prefetch_distance) {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            const size_t start = pos;
+            const size_t heap_distance = prefetch_distance / 2;
+            while (pos - start < max_items) {
+                if (prefetch_distance != 0) {
+                    const node_& slot = buffer_[(pos + prefetch_distance) & (capacity_ - 1)];
+                    prefetch_for_read(&slot.item_); // a slot can straddle two lines, the item starts one
+                    prefetch_for_read(&slot.seq_);  // and the sequence usually ends the other
+                    const node_& ahead = buffer_[(pos + heap_distance) & (capacity_ - 1)];
+                    if (ahead.seq_.load(std::memory_order_acquire) == pos + heap_distance + 1) {
+                        prefetch_item_heap(ahead.item_);
+                    }
+                }
+                node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                out.push_back(std::move(node.item_));
+                node.seq_.store(pos + capacity_, std::memory_order_release);
+                ++pos;
+            }
+            head_.store(pos, std::memory_order_relaxed);
+            return pos - start;
+        }
+
+        // Visits the events that are published but not yet dequeued, oldest first, without consuming them.
+        // Only meaningful while producers and the consumer are quiesced (snapshots on controlled shutdown).
+        template<typename Visitor>
+        void for_each_pending(Visitor&& visitor) const {
+            const size_t tail = tail_.load(std::memory_order_acquire) & ~CLOSED_BIT;
+            for (size_t pos = head_.load(std::memory_order_acquire); pos != tail; ++pos) {
+                const node_& node = buffer_[pos & (capacity_ - 1)];
+                if (node.seq_.load(std::memory_order_acquire) != pos + 1) {
+                    break; // slot claimed but not written yet
+                }
+                visitor(node.item_);
+            }
+        }
+
+        // Consumer cursor, i.e. how many events were ever dequeued from this queue
+        [[nodiscard]] size_t head_position() const {
+            return head_.load(std::memory_order_acquire);
+        }
+
+        // Producer cursor, i.e. how many slots were ever claimed. Claimed slots are always written eventually.
+        [[nodiscard]] size_t tail_position() const {
+            return tail_.load(std::memory_order_acquire) & ~CLOSED_BIT;
+        }
+
+        // Stops all further enqueues so the queue can be drained and retired, e.g. when migrating to a new capacity.
+        // Producers that already claimed a slot still complete their write.
+        void close() {
+            tail_.fetch_or(CLOSED_BIT, std::memory_order_acq_rel);
+        }
+
+        [[nodiscard]] bool is_closed() const {
+            return (tail_.load(std::memory_order_acquire) & CLOSED_BIT) != 0;
+        }
+
+        // A closed queue is drained once the consumer has caught up with the last claimed slot
+        [[nodiscard]] bool is_drained() const {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            return (tail & CLOSED_BIT) != 0 && head_.load(std::memory_order_relaxed) == (tail & ~CLOSED_BIT);
+        }
+
+        // Claimed but not yet dequeued slots, a racy estimate meant for sizing decisions
+        [[nodiscard]] size_t size_approx() const {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t tail = tail_.load(std::memory_order_relaxed) & ~CLOSED_BIT;
+            return tail > head ? tail - head : 0;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return capacity_;
+        }
+
+        // Bytes held by the slot array itself, excluding anything the items own on the heap
+        static constexpr size_t memory_bytes_for_capacity(const size_t capacity) {
+            return capacity * sizeof(node_);
+        }
+
         void debug_print() {
             std::cout << "head: " << head_.load() << ", tail: " << tail_.load() << std::endl;
             for (size_t i = 0; i < capacity_; ++i) {
@@ -81,6 +220,8 @@ namespace eventbus {
         }
 
     private:
+        static constexpr size_t CLOSED_BIT = size_t{1} << (sizeof(size_t) * 8 - 1);
+
         struct node_ {
             T item_;
             std::atomic<size_t> seq_;
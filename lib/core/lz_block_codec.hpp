@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace eventbus {
+    // Small in-tree LZ77 block codec using the LZ4 block layout:
+    // [token][literal length ext...][literals][offset lo][offset hi][match length ext...]
+    // token = (literal_length << 4) | (match_length - MIN_MATCH), a nibble of 15 means more length bytes follow.
+    // The last sequence of a block only carries literals. No framing here, callers store the raw size themselves.
+    class LzBlockCodec {
+    public:
+        // Largest block decompress() accepts, so a corrupted size field cannot make it reserve gigabytes
+        static constexpr size_t MAX_BLOCK_SIZE = size_t{1} << 30;
+
+        static void compress(const char* src, const size_t src_size, std::string& out) {
+            const auto* in = reinterpret_cast<const uint8_t*>(src);
+            std::array<uint32_t, HASH_TABLE_SIZE> table{}; // stores position + 1, 0 means empty
+
+            size_t anchor = 0;
+            size_t ip = 0;
+            // Keep the tail of the block as literals so the match extension never reads past the input
+            const size_t match_limit = src_size > LAST_LITERALS ? src_size - LAST_LITERALS : 0;
+
+            while (ip + MIN_MATCH <= match_limit) {
+                const uint32_t sequence = read32(in + ip);
+                const uint32_t hash = hash_sequence(sequence);
+                const uint32_t candidate = table[hash];
+                table[hash] = static_cast<uint32_t>(ip + 1);
+
+                if (candidate != 0) {
+                    const size_t match_pos = candidate - 1;
+                    const size_t offset = ip - match_pos;
+                    if (offset <= MAX_OFFSET && read32(in + match_pos) == sequence) {
+                        size_t match_length = MIN_MATCH;
+                        while (ip + match_length < match_limit && in[match_pos + match_length] == in[ip + match_length]) {
+                            ++match_length;
+                        }
+                        write_sequence(out, in + anchor, ip - anchor, offset, match_length);
+                        ip += match_length;
+                        anchor = ip;
+                        continue;
+                    }
+                }
+                // Skip faster through data that does not compress
+                ip += 1 + ((ip - anchor) >> SKIP_SHIFT);
+            }
+
+            write_last_literals(out, in + anchor, src_size - anchor);
+        }
+
+        // Appends the decompressed bytes to out, expected_size is the raw size recorded by the caller
+        static void decompress(const char* src, const size_t src_size, const size_t expected_size, std::string& out) {
+            if (expected_size > MAX_BLOCK_SIZE || expected_size > max_decompressed_size(src_size)) {
+                throw std::runtime_error("Corrupted compressed block - raw size out of range");
+            }
+            const auto* in = reinterpret_cast<const uint8_t*>(src);
+            const size_t out_start = out.size();
+            out.reserve(out_start + expected_size);
+            size_t ip = 0;
+
+            while (ip < src_size) {
+                const uint8_t token = in[ip++];
+
+                const size_t literal_length = read_length(in, src_size, ip, token >> 4);
+                if (literal_length > src_size - ip) {
+                    throw std::runtime_error("Corrupted compressed block - literals out of bounds");
+                }
+                out.append(reinterpret_cast<const char*>(in + ip), literal_length);
+                ip += literal_length;
+
+                if (ip == src_size) {
+                    break; // last sequence only has literals
+                }
+
+                if (src_size - ip < 2) {
+                    throw std::runtime_error("Corrupted compressed block - truncated offset");
+                }
+                const size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+                ip += 2;
+                const size_t match_length = read_length(in, src_size, ip, token & 0x0F) + MIN_MATCH;
+
+                const size_t produced = out.size() - out_start;
+                if (offset == 0 || offset > produced || produced + match_length > expected_size) {
+                    throw std::runtime_error("Corrupted compressed block - invalid match");
+                }
+                // Byte by byte copy because the match is allowed to overlap the bytes it produces
+                size_t match_pos = out.size() - offset;
+                for (size_t i = 0; i < match_length; ++i) {
+                    out.push_back(out[match_pos++]);
+                }
+            }
+
+            if (out.size() - out_start != expected_size) {
+                throw std::runtime_error("Corrupted compressed block - size mismatch");
+            }
+        }
+
+        // Worst case output size, incompressible input grows by the extended literal length bytes only
+        static size_t max_compressed_size(const size_t src_size) {
+            return src_size + src_size / 255 + 16;
+        }
+
+        // Most a block of src_size bytes can expand to: a match length byte stands for at most 255 bytes, and no
+        // other byte of a block stands for more
+        static size_t max_decompressed_size(const size_t src_size) {
+            return src_size * 255;
+        }
+
+    private:
+        static constexpr size_t MIN_MATCH = 4;
+        static constexpr size_t LAST_LITERALS = 5;
+        static constexpr size_t MAX_OFFSET = 65535;
+        static constexpr size_t HASH_LOG = 12;
+        static constexpr size_t HASH_TABLE_SIZE = 1 << HASH_LOG;
+        static constexpr size_t SKIP_SHIFT = 6;
+
+        static uint32_t read32(const uint8_t* p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        static uint32_t hash_sequence(const uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HASH_LOG);
+        }
+
+        static void write_length(std::string& out, size_t length) {
+            while (length >= 255) {
+                out.push_back(static_cast<char>(255));
+                length -= 255;
+            }
+            out.push_back(static_cast<char>(length));
+        }
+
+        static size_t read_length(const uint8_t* in, const size_t src_size, size_t& ip, const size_t nibble) {
+            size_t length = nibble;
+            if (nibble != 15) {
+                return length;
+            }
+            uint8_t byte;
+            do {
+                if (ip >= src_size) {
+                    throw std::runtime_error("Corrupted compressed block - truncated length");
+                }
+                byte = in[ip++];
+                length += byte;
+            } while (byte == 255);
+            return length;
+        }
+
+        static void write_sequence(std::string& out, const uint8_t* literals, const size_t literal_length,
+            const size_t offset, const size_t match_length) {
+            const size_t match_code = match_length - MIN_MATCH;
+            const uint8_t token = static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) |
+                                                       std::min<size_t>(match_code, 15));
+            out.push_back(static_cast<char>(token));
+            if (literal_length >= 15) {
+                write_length(out, literal_length - 15);
+            }
+            out.append(reinterpret_cast<const char*>(literals), literal_length);
+            out.push_back(static_cast<char>(offset & 0xFF));
+            out.push_back(static_cast<char>((offset >> 8) & 0xFF));
+            if (match_code >= 15) {
+                write_length(out, match_code - 15);
+            }
+        }
+
+        static void write_last_literals(std::string& out, const uint8_t* literals, const size_t literal_length) {
+            out.push_back(static_cast<char>(std::min<size_t>(literal_length, 15) << 4));
+            if (literal_length >= 15) {
+                write_length(out, literal_length - 15);
+            }
+            out.append(reinterpret_cast<const char*>(literals), literal_length);
+        }
+    };
+}
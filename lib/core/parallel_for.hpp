@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace eventbus {
+    // Runs task(i) for every i in [0, count) on up to thread_count threads, the calling thread included.
+    // Indices are handed out one by one, so uneven tasks still balance. Meant for one-off bulk work such as
+    // building the topology at startup, not for the hot path: threads are started per call.
+    // The first exception thrown by a task stops the remaining indices and is rethrown on the caller.
+    template<typename Task>
+    void parallel_for(const size_t count, size_t thread_count, Task&& task) {
+        if (thread_count == 0) {
+            thread_count = std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 1;
+        }
+        if (thread_count > count) {
+            thread_count = count;
+        }
+
+        std::atomic<size_t> next_index{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+        const auto run = [&] {
+            for (size_t i = next_index.fetch_add(1, std::memory_order_relaxed); i < count && !failed.load(std::memory_order_relaxed);
+                 i = next_index.fetch_add(1, std::memory_order_relaxed)) {
+                try {
+                    task(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(failure_mutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < thread_count; ++i) {
+            try {
+                threads.emplace_back(run);
+            } catch (const std::system_error&) {
+                break; // out of threads, the ones we have still get through every index
+            }
+        }
+        run();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace eventbus {
+    // Read prefetch hint, a no-op on compilers without the builtin
+    inline void prefetch_for_read(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address, 0, 3);
+#else
+        (void)address;
+#endif
+    }
+
+    // Rings call this on items that are published but not consumed yet, so the consumer's later reads of heap
+    // memory owned by the item do not stall. Overload it next to types that own heap buffers.
+    template<typename T>
+    void prefetch_item_heap(const T&) {}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace eventbus {
+    // Read-copy-update cell for rarely changing, frequently read values (configs, routing tables).
+    // Readers do a single acquire load and never block. Writers are serialized and publish a fresh copy; replaced
+    // versions are retired rather than freed because a reader may still be using them. They are released when the
+    // cell is destroyed, which is fine for values that change a handful of times in a process lifetime.
+    template<typename T>
+    class RcuPtr {
+    public:
+        explicit RcuPtr(std::unique_ptr<T> initial) : current_(initial.get()) {
+            versions_.push_back(std::move(initial));
+        }
+
+        RcuPtr(const RcuPtr&) = delete;
+        RcuPtr& operator=(const RcuPtr&) = delete;
+
+        [[nodiscard]] const T* load() const {
+            return current_.load(std::memory_order_acquire);
+        }
+
+        void update(std::unique_ptr<T> next) {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            current_.store(next.get(), std::memory_order_release);
+            versions_.push_back(std::move(next));
+        }
+
+    private:
+        std::atomic<T*> current_;
+        std::mutex writer_mutex_;
+        std::vector<std::unique_ptr<T>> versions_; // current and retired versions, writers only
+    };
+}
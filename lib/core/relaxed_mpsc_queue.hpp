@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock_free_mpsc_queue.hpp"
+
+namespace eventbus {
+    // Relaxed FIFO queue for topics that do not care about order: the capacity is split over a few independent
+    // LockFreeMpscQueue lanes, every enqueue starts at a random lane and the consumer rotates over them.
+    // Producers only contend when they happen to pick the same lane, so adding producers scales close to linearly
+    // instead of piling up on one tail_. Order only holds within a lane, i.e. per producer it holds only while that
+    // producer keeps landing on the same lane.
+    // Same interface as LockFreeMpscQueue so it can back a partition lane, including close() for migrations.
+    template<typename T>
+    class RelaxedMpscQueue {
+
+    public:
+        static constexpr size_t DEFAULT_LANE_COUNT = 8; // power of two, capped so every lane gets MIN_LANE_CAPACITY
+        // In a one slot LockFreeMpscQueue a published slot also reads as free, producers overwrite it unread
+        static constexpr size_t MIN_LANE_CAPACITY = 2;
+
+        explicit RelaxedMpscQueue(const size_t capacity, const size_t lane_count = DEFAULT_LANE_COUNT)
+               : capacity_(capacity),
+                 lane_mask_(lane_count_for(capacity, lane_count) - 1) {
+            const size_t lanes = lane_mask_ + 1;
+            lanes_.reserve(lanes);
+            for (size_t i = 0; i < lanes; ++i) {
+                lanes_.push_back(std::make_unique<LockFreeMpscQueue<T>>(capacity_ / lanes));
+            }
+        }
+
+        // Falls through to the other lanes before reporting full, so the whole capacity stays usable
+        bool enqueue(const T& item) {
+            const size_t start = next_random() & lane_mask_;
+            for (size_t i = 0; i <= lane_mask_; ++i) {
+                if (lanes_[(start + i) & lane_mask_]->enqueue(item)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // The batch goes to one random lane as a whole when it fits, spilling into the following lanes otherwise
+        size_t enqueue_batch(const T* items, const size_t count) {
+            const size_t start = next_random() & lane_mask_;
+            size_t enqueued = 0;
+            for (size_t i = 0; i <= lane_mask_ && enqueued < count; ++i) {
+                enqueued += lanes_[(start + i) & lane_mask_]->enqueue_batch(items + enqueued, count - enqueued);
+            }
+            return enqueued;
+        }
+
+        bool dequeue(T& item) {
+            for (size_t i = 0; i <= lane_mask_; ++i) {
+                LockFreeMpscQueue<T>& lane = *lanes_[next_lane_];
+                next_lane_ = (next_lane_ + 1) & lane_mask_;
+                if (lane.dequeue(item)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Takes from the lanes in turn, starting one lane further on every call
+        size_t dequeue_batch(std::vector<T>& out, const size_t max_items, const size_t prefetch_distance) {
+            size_t taken = 0;
+            for (size_t i = 0; i <= lane_mask_ && taken < max_items; ++i) {
+                taken += lanes_[(next_lane_ + i) & lane_mask_]->dequeue_batch(out, max_items - taken, prefetch_distance);
+            }
+            next_lane_ = (next_lane_ + 1) & lane_mask_;
+            return taken;
+        }
+
+        // Lane by lane, so only oldest first within a lane. Producers and consumer must be quiesced.
+        template<typename Visitor>
+        void for_each_pending(Visitor&& visitor) const {
+            for (const auto& lane : lanes_) {
+                lane->for_each_pending(visitor);
+            }
+        }
+
+        // Consumer cursor, i.e. how many events were ever dequeued from this queue
+        [[nodiscard]] size_t head_position() const {
+            size_t position = 0;
+            for (const auto& lane : lanes_) {
+                position += lane->head_position();
+            }
+            return position;
+        }
+
+        // Producer cursor summed over the lanes, not a snapshot while producers are active
+        [[nodiscard]] size_t tail_position() const {
+            size_t position = 0;
+            for (const auto& lane : lanes_) {
+                position += lane->tail_position();
+            }
+            return position;
+        }
+
+        // Lane 0 is closed first, so a producer that bounced off any closed lane also sees is_closed()
+        void close() {
+            for (const auto& lane : lanes_) {
+                lane->close();
+            }
+        }
+
+        [[nodiscard]] bool is_closed() const {
+            return lanes_[0]->is_closed();
+        }
+
+        [[nodiscard]] bool is_drained() const {
+            for (const auto& lane : lanes_) {
+                if (!lane->is_drained()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] size_t size_approx() const {
+            size_t size = 0;
+            for (const auto& lane : lanes_) {
+                size += lane->size_approx();
+            }
+            return size;
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return capacity_;
+        }
+
+        static constexpr size_t memory_bytes_for_capacity(const size_t capacity) {
+            return LockFreeMpscQueue<T>::memory_bytes_for_capacity(capacity);
+        }
+
+    private:
+        static size_t lane_count_for(const size_t capacity, const size_t lane_count) {
+            if (capacity < MIN_LANE_CAPACITY) {
+                throw std::runtime_error("Relaxed ring capacity - " + std::to_string(capacity) +
+                                         " is below the minimum of " + std::to_string(MIN_LANE_CAPACITY));
+            }
+            const size_t max_lanes = capacity / MIN_LANE_CAPACITY;
+            return lane_count < max_lanes ? lane_count : max_lanes;
+        }
+
+        // xorshift per producer thread, seeded from the thread id so threads start on different lanes
+        static uint32_t next_random() {
+            thread_local uint32_t state = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        size_t capacity_;
+        size_t lane_mask_;
+        std::vector<std::unique_ptr<LockFreeMpscQueue<T>>> lanes_;
+        size_t next_lane_{0}; // consumer only
+    };
+}
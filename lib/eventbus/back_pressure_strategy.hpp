@@ -44,6 +44,10 @@ namespace eventbus {
                     return handle_drop_newest(queue, event);
             }
         }
+
+        [[nodiscard]] const BackPressureConfig& config() const {
+            return config_;
+        }
     private:
         BackPressureConfig config_;
 
@@ -1,26 +1,205 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <queue>
+
 #include "consumer_group.hpp"
+#include "consumer_notifier.hpp"
 #include "event.hpp"
-#include "lock_free_mpsc_queue.hpp"
+#include "partition_queue.hpp"
 #include <vector>
 
 namespace eventbus {
+    struct AdaptiveBatchConfig {
+        // How long an event may wait between being dequeued and its batch being handled, i.e. batch size times
+        // the measured handler cost per event
+        std::chrono::nanoseconds latency_target = std::chrono::microseconds(500);
+        size_t min_batch = 1;
+        size_t max_batch = 4096;
+    };
+
+    // What poll_merged_batch() orders by
+    enum class MergeOrder {
+        TIMESTAMP, // Event::timestamp, any topic, a best effort order between partitions
+        SEQUENCE   // Event::sequence of a total order topic, the exact publish order when nothing was dropped
+    };
+
+    struct MergeConfig {
+        size_t lookahead = 64; // events staged per partition while merging
+        // TIMESTAMP: a partition with nothing staged holds the merge back for at most this long, after that it is
+        // assumed to have nothing older than the events already waiting.
+        // SEQUENCE: a missing sequence holds the merge back for at most this long, after that it is assumed dropped.
+        std::chrono::nanoseconds max_skew = std::chrono::microseconds(100);
+        MergeOrder order = MergeOrder::TIMESTAMP;
+    };
+
     class Consumer {
     public:
         explicit Consumer(ConsumerGroup& consumer_group);
 
-        void receive_queues(const std::vector<std::shared_ptr<LockFreeMpscQueue<Event>>>& queues);
+        void receive_queues(const std::vector<std::shared_ptr<PartitionQueue>>& queues);
+
+        // Partitions added by a repartition, control plane side. They are appended to the assignment on the
+        // consumer thread at the start of its next poll.
+        void add_queues(const std::vector<std::shared_ptr<PartitionQueue>>& queues);
+
+        // Takes over partitions handed in by add_queues(). Every poll does this itself, dispatchers that go
+        // through poll_partition() call it before looking at assigned_partition_count().
+        void adopt_added_queues() const;
 
         [[nodiscard]] const std::vector<Event>& poll_batch(size_t max_events = 100) const;
 
+        // Throughput oriented poll: keeps collecting until at least min_events are there or max_wait has passed,
+        // then returns whatever it has (possibly fewer than min_events, possibly nothing). Spins briefly first,
+        // then yields, then parks in short sleeps so an idle consumer does not burn a core.
+        [[nodiscard]] const std::vector<Event>& poll_batch(size_t max_events, size_t min_events,
+            std::chrono::microseconds max_wait) const;
+
         [[nodiscard]] const std::string& consumer_id() const {
             return consumer_id_;
         }
 
+        // Epoll integration: returns an eventfd that turns readable when producers enqueue into this consumer's
+        // partitions while it is armed. Call once, on the consumer thread, before it starts polling. From then on
+        // every enqueue into its partitions costs the producer a fence and a load, plus an fd write when armed.
+        int enable_notification();
+
+        // Call before going back to epoll_wait. Clears the fd and arms it. False when events are already waiting
+        // (or merge mode has some staged), poll again instead of waiting. A partition still fenced by a repartition
+        // does not count as waiting, the fd turns readable once the fence can open.
+        [[nodiscard]] bool arm_notification() const;
+
+
+        // Per partition access for dispatchers that need to know where an event came from (ParallelConsumer)
+        [[nodiscard]] size_t assigned_partition_count() const {
+            return queues_.size();
+        }
+
+        // Appends up to max_events from one assigned partition to out, returns how many were taken. With runs,
+        // appends which lane and lane position the events came from, so they can be acknowledged lane by lane.
+        size_t poll_partition(size_t assigned_index, std::vector<Event>& out, size_t max_events,
+            std::vector<DeliveredRun>* runs = nullptr) const;
+
+        // Adaptive mode: poll_adaptive_batch() sizes each batch from the current queue depth and the handler cost
+        // per event, growing under backlog and shrinking when idle while keeping batch size x cost under the latency
+        // target. The cost is measured from the poll returning to adaptive_batch_handled(), so time the caller spends
+        // idle or on other work between polls does not count. Without those calls batches follow the depth alone.
+        void set_adaptive_batching(const AdaptiveBatchConfig& config);
+
+        [[nodiscard]] const std::vector<Event>& poll_adaptive_batch() const;
+
+        // Call once the batch of the last poll_adaptive_batch() was handled
+        void adaptive_batch_handled() const;
+
+        // Merge mode: poll_merged_batch() returns events of all assigned partitions in Event::timestamp order,
+        // keeping the ring order within each partition. Events are staged per partition and merged through a
+        // heap with one entry per partition. Staged events are invisible to the other polls, do not mix them.
+        // With MergeOrder::SEQUENCE events come out in Event::sequence order instead, each one as soon as every
+        // smaller sequence was delivered. That is the total publish order only if this consumer reads every
+        // partition of the topic: the only consumer of its group, or a broadcast group. Set it before polling.
+        void set_merge_ordering(const MergeConfig& config);
+
+        [[nodiscard]] const std::vector<Event>& poll_merged_batch(size_t max_events = 100) const;
+
+        // Acknowledged groups (ConsumerGroupConfig::acknowledged) give at least once delivery: a dequeued event keeps
+        // its ring slot until acknowledged, and redeliver_unacknowledged() hands the rest out again. Acknowledging
+        // is cumulative per partition lane, like committing an offset. acknowledge() covers everything polled so far,
+        // acknowledge(event) an event of the last batch plus everything before it from the same partition lane.
+        // Unacknowledged events count against the ring, so a consumer that never acknowledges stalls its producers.
+        // Merged polls are not available, their staged events would be acknowledged before being handed out.
+        void acknowledge() const;
+        void acknowledge(const Event& event) const;
+
+        [[nodiscard]] bool is_acknowledged() const {
+            return acknowledged_;
+        }
+
+        // After a failure, on the thread that takes this consumer over: the next poll starts again at the first
+        // event not acknowledged in every assigned partition.
+        void redeliver_unacknowledged() const;
+
+        // How many ring slots ahead the drain loop prefetches, 0 (default) turns prefetching off. Whether it pays off
+        // depends on the hardware, measure with prefetch_drain_benchmark before turning it on.
+        void set_prefetch_distance(const size_t prefetch_distance) {
+            prefetch_distance_ = prefetch_distance;
+        }
+
+        // Batch size the next poll_adaptive_batch() starts from
+        [[nodiscard]] size_t adaptive_batch_size() const {
+            return adaptive_batch_size_;
+        }
 
     private:
-        std::vector<std::shared_ptr<LockFreeMpscQueue<Event>>> queues_;
+        static constexpr int POLL_SPIN_ROUNDS = 64;
+        static constexpr int POLL_YIELD_ROUNDS = 64;
+        static constexpr std::chrono::microseconds POLL_PARK_DURATION{50};
+
+        struct MergeHead {
+            std::chrono::steady_clock::time_point timestamp;
+            size_t queue_index;
+
+            bool operator>(const MergeHead& other) const {
+                return timestamp != other.timestamp ? timestamp > other.timestamp : queue_index > other.queue_index;
+            }
+        };
+
+        struct SequenceHead {
+            size_t sequence;
+            size_t queue_index;
+            size_t slot; // in sequence_slots_
+
+            bool operator>(const SequenceHead& other) const {
+                return sequence != other.sequence ? sequence > other.sequence : queue_index > other.queue_index;
+            }
+        };
+
+        [[nodiscard]] bool has_pending_events() const;
+
+        // Appends up to max_events to batch_buffer_, spread over the assigned queues
+        size_t drain_into_batch(size_t max_events) const;
+
+        void require_acknowledged() const;
+
+        // Refills the staging of one queue once it is used up, and puts its oldest staged event on the heap
+        void stage_merge_queue(size_t queue_index) const;
+
+        // Merge bodies of poll_merged_batch(), appending to batch_buffer_
+        void merge_by_timestamp(size_t max_events) const;
+        void merge_by_sequence(size_t max_events) const;
+
+        // Moves up to max_events of one queue onto the sequence heap
+        void stage_sequence_queue(size_t queue_index, size_t max_events) const;
+
+        mutable std::vector<std::shared_ptr<PartitionQueue>> queues_; // grows on the consumer thread only
         std::string consumer_id_;
+        bool acknowledged_;
+        mutable std::mutex added_queues_mutex_;
+        mutable std::vector<std::shared_ptr<PartitionQueue>> added_queues_; // guarded by added_queues_mutex_
+        mutable std::atomic<bool> has_added_queues_{false};
+        std::unique_ptr<ConsumerNotifier> notifier_; // set once by enable_notification(), outlives the lanes' use of it
         mutable std::vector<Event> batch_buffer_;
+        mutable std::vector<DeliveredRun> delivered_runs_; // of batch_buffer_, acknowledged groups only
+        AdaptiveBatchConfig adaptive_config_;
+        mutable size_t adaptive_batch_size_{1};
+        mutable double handler_ns_per_event_{0}; // moving average, 0 until the first batch was handled
+        mutable size_t last_batch_size_{0}; // 0 once its handler time was sampled
+        mutable std::chrono::steady_clock::time_point last_poll_returned_at_;
+        mutable size_t next_queue_{0}; // first queue of the next drain, rotates so small drains do not favour queue 0
+        size_t prefetch_distance_{0};
+        MergeConfig merge_config_;
+        mutable std::vector<std::vector<Event>> merge_staging_; // per queue
+        mutable std::vector<size_t> merge_read_; // next staged event per queue
+        mutable std::priority_queue<MergeHead, std::vector<MergeHead>, std::greater<>> merge_heap_; // queues with staged events
+        // Every staged event, min heap by sequence. The events sit in slots so sifting only moves the small heads.
+        mutable std::vector<SequenceHead> sequence_heap_;
+        mutable std::vector<Event> sequence_slots_;
+        mutable std::vector<size_t> free_sequence_slots_;
+        mutable std::vector<size_t> sequence_staged_; // per queue, its events on sequence_heap_
+        mutable std::vector<Event> sequence_scratch_;
+        mutable size_t next_sequence_{1}; // smallest sequence not delivered yet
+        mutable bool sequence_gap_open_{false};
+        mutable std::chrono::steady_clock::time_point sequence_gap_since_; // when next_sequence_ was first missed
     };
 }
\ No newline at end of file
@@ -1,27 +1,93 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
 
-#include "back_pressure_strategy.hpp"
 #include "event.hpp"
-#include "lock_free_mpsc_queue.hpp"
+#include "partition_queue.hpp"
+#include "rcu_ptr.hpp"
+#include "snapshot.hpp"
 
 namespace eventbus {
     class Consumer;
+
+    // A queueing group splits the partitions among its consumers. A broadcast group hands every partition to every
+    // consumer: they all read one ring per partition lane, each through its own cursor, so a publish is still a
+    // single enqueue per group however many consumers there are.
+    // An acknowledged group keeps events in their slots until its consumers acknowledge them, see PartitionLane.
     class ConsumerGroup {
     public:
-        ConsumerGroup(std::string group_id, size_t partition_count);
+        ConsumerGroup(std::string group_id, size_t partition_count, size_t queue_capacity = 16384,
+            std::vector<size_t> isolated_lane_capacities = {}, QueueEngine queue_engine = QueueEngine::CAS_RING,
+            const RingAllocation& ring_allocation = {}, bool broadcast = false, bool acknowledged = false);
         std::string register_consumer(Consumer* consumer);
         void create_partition_assignments_among_consumers_();
 
-        // called by bus to deliver message to one of the partitions of topic that this consumer is consuming from.
-        bool deliver_event_to_consumer_group(const Event& event, size_t partition_index, const BackPressureHandler& back_pressure_handler) const;
+        // Snapshot support, both require publishers and consumers of this group to be stopped
+        [[nodiscard]] std::vector<PartitionSnapshot> snapshot_partitions() const;
+        void restore_partitions(const std::vector<PartitionSnapshot>& partitions);
+
+        [[nodiscard]] const std::string& group_id() const {
+            return group_id_;
+        }
+
+        [[nodiscard]] const std::vector<std::shared_ptr<PartitionQueue>>& partition_queues() const {
+            return *partition_queues_.load();
+        }
+
+        [[nodiscard]] size_t partition_count() const {
+            return topic_partition_count_;
+        }
+
+        [[nodiscard]] size_t queue_capacity() const {
+            return queue_capacity_;
+        }
+
+        // BROADCAST_RING for a broadcast or acknowledged group whatever the topic picked
+        [[nodiscard]] QueueEngine queue_engine() const {
+            return queue_engine_;
+        }
+
+        [[nodiscard]] bool is_broadcast() const {
+            return broadcast_;
+        }
+
+        [[nodiscard]] bool is_acknowledged() const {
+            return acknowledged_;
+        }
+
+        // Changes the shared lane capacity of every partition while publishers keep running, see PartitionLane::resize.
+        // Tenant lanes are sized by their tenant, so groups that have any cannot be migrated.
+        void migrate_partition_queues(size_t queue_capacity);
+
+        [[nodiscard]] bool has_isolated_lanes() const {
+            return !isolated_lane_capacities_.empty();
+        }
+
+        // Repartition support, control plane only. add_partitions() appends fenced partitions and hands them to
+        // consumers round robin, publishers may route into them as soon as the topic count moves.
+        // fence_added_partitions() must follow once no publisher routes with the old count anymore.
+        void add_partitions(size_t partition_count);
+        void fence_added_partitions(size_t old_partition_count) const;
 
     private:
+        using QueueAssignments = std::unordered_map<size_t, std::vector<std::shared_ptr<PartitionQueue>>>;
+
+        [[nodiscard]] std::shared_ptr<PartitionQueue> make_partition_queue(bool fenced) const;
+        void assign_partition(size_t partition_index, const std::shared_ptr<PartitionQueue>& partition_queue,
+            QueueAssignments& assignments) const;
+
         std::string group_id_; // Consumer group id
         std::atomic<size_t> next_consumer_idx_{0}; // tracks the consumer that's connecting to this group
         size_t topic_partition_count_; // partition count of the topic that this group consumes from
-        std::vector<std::shared_ptr<LockFreeMpscQueue<Event>>> partition_queues_; // queue for each partition
-        std::unordered_map<size_t, std::vector<std::shared_ptr<LockFreeMpscQueue<Event>>>> queue_assignments_by_consumer_index_; // consumer to list of queue map.
+        size_t queue_capacity_; // slots per partition queue
+        std::vector<size_t> isolated_lane_capacities_; // extra tenant lanes 1..n in every partition queue
+        QueueEngine queue_engine_; // ring engine of every lane, picked by the topic
+        RingAllocation ring_allocation_; // lazy and growing rings, picked by the topic
+        bool broadcast_;
+        bool acknowledged_;
+        RcuPtr<std::vector<std::shared_ptr<PartitionQueue>>> partition_queues_; // queue for each partition, grows on repartition
+        QueueAssignments queue_assignments_by_consumer_index_; // consumer to list of queue map, reader views in a broadcast group
         std::vector<Consumer*> assigned_consumers_;
         bool finalized_consumer_group_{false};
     };
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+
+namespace eventbus {
+    // eventfd a consumer hands to an epoll loop instead of polling from a thread of its own. The fd turns readable
+    // when one of the consumer's partitions gets an event while the consumer is armed, i.e. idle and about to wait.
+    // Signaling is coalesced: the first producer to find the notifier armed disarms it and writes the fd, every
+    // other producer gets away with one fence and one load, so the fd is written at most once per empty to non-empty
+    // transition.
+    class ConsumerNotifier {
+    public:
+        ConsumerNotifier();
+        ~ConsumerNotifier();
+
+        ConsumerNotifier(const ConsumerNotifier&) = delete;
+        ConsumerNotifier& operator=(const ConsumerNotifier&) = delete;
+
+        [[nodiscard]] int fd() const {
+            return fd_;
+        }
+
+        // Producer side, once the event is visible in the ring
+        void notify() {
+            // Pairs with the fence in arm(): either the consumer sees the event when it checks its partitions after
+            // arming, or this load sees the notifier armed
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (armed_.load(std::memory_order_relaxed) && armed_.exchange(false, std::memory_order_acq_rel)) {
+                signal();
+            }
+        }
+
+        // Consumer side. Arm, then check the partitions once more before waiting on the fd.
+        void arm() {
+            armed_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        void disarm() {
+            armed_.store(false, std::memory_order_relaxed);
+        }
+
+        // Resets the fd to not readable
+        void clear() const;
+
+    private:
+        void signal() const;
+
+        int fd_;
+        alignas(64) std::atomic<bool> armed_{false};
+    };
+}
@@ -1,4 +1,11 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -8,114 +15,905 @@
 #include "consumer_group.hpp"
 #include "event.hpp"
 #include "event_bus_config.hpp"
-#include "lock_free_mpsc_queue.hpp"
+#include "memory_usage.hpp"
+#include "parallel_for.hpp"
+#include "partition_queue.hpp"
+#include "publisher.hpp"
+#include "rcu_ptr.hpp"
+#include "runtime_config.hpp"
+#include "snapshot.hpp"
+#include "tenant.hpp"
 #include "topic.hpp"
 
 namespace eventbus {
-    using queue_ptr = std::shared_ptr<LockFreeMpscQueue<Event>>;
+    using queue_ptr = std::shared_ptr<PartitionQueue>;
 
     class EventBus {
+        friend class Publisher; // batches through assign_event_partition and deliver_batch
+        template<typename Topology>
+        friend class StaticEventBus; // publishes straight to topics it resolved up front
+        friend class ReplicationSender; // reads the lanes of replication groups and the cursors of every group
+        friend class StandbyReplica; // restores the replication groups along with the others
 
     public:
         explicit EventBus(const EventBusConfig& event_bus_config, const BackPressureConfig& back_pressure_config = {})
-            : backpressure_handler_(back_pressure_config) {
+            : backpressure_handler_(std::make_unique<BackPressureHandler>(back_pressure_config)),
+              memory_budget_bytes_(event_bus_config.memory_budget_bytes) {
             for (const auto& topic_config: event_bus_config.topics) {
-                create_topic(topic_config.name, topic_config.partition_count);
+                if (topic_config.replicated && back_pressure_config.strategy != BackPressureStrategy::BLOCK) {
+                    throw std::runtime_error("Replicated topic - " + topic_config.name +
+                        " needs BLOCK back-pressure, a group that drops events no longer lines up with the standby");
+                }
+                create_topic(topic_config);
             }
 
+            for (const auto& tenant_config : event_bus_config.tenants) {
+                create_tenant(tenant_config);
+            }
+
+            RingBytes reserved(tenants_.size()); // tallied as groups are added, nothing is allocated yet
+            std::vector<std::shared_ptr<ConsumerGroup>> consumer_groups;
+            consumer_groups.reserve(event_bus_config.consumer_groups.size());
             for (const auto& consumer_group_config  : event_bus_config.consumer_groups) {
-                create_consumer_group(consumer_group_config.group_id, consumer_group_config.topic_name,
-                    consumer_group_config.consumer_count);
+                consumer_groups.push_back(create_consumer_group(consumer_group_config.group_id,
+                    consumer_group_config.topic_name, consumer_group_config.consumer_count, consumer_group_config.tenant,
+                    consumer_group_config.broadcast, consumer_group_config.acknowledged, reserved));
+            }
+            for (const auto& topic_config : event_bus_config.topics) {
+                if (topic_config.replicated) {
+                    const std::string group_id = replication_group_id(topic_config.name);
+                    consumer_groups.push_back(create_consumer_group(group_id, topic_config.name, 1, "", false, false,
+                        reserved));
+                    replication_groups_.push_back(consumer_groups.back().get());
+                    // Nobody polls the hidden group, its consumer only exists because every group is set up with one
+                    auto consumers_it = consumers_by_consumer_group_id_.find(group_id);
+                    replication_consumers_.push_back(std::move(consumers_it->second.front()));
+                    consumers_by_consumer_group_id_.erase(consumers_it);
+                }
             }
+
+            // Allocating and initializing the rings is the bulk of startup and groups share nothing, so they are
+            // built in parallel. Routes are built once per topic afterwards.
+            parallel_for(consumer_groups.size(), event_bus_config.startup_threads, [&](const size_t group_index) {
+                consumer_groups[group_index]->create_partition_assignments_among_consumers_();
+            });
+            for (auto& [topic_name, topic] : topics_) {
+                update_topic_routes(topic);
+            }
+            apply_payload_budgets();
+            start_replication_drain();
         }
 
+        ~EventBus() {
+            stop_replication_drain();
+        }
+
+        EventBus(const EventBus&) = delete;
+        EventBus& operator=(const EventBus&) = delete;
+
         bool publish_event(const Event& event, const std::string& partition_key = "") {
+            return publish_event_to_lane(event, partition_key, 0);
+        }
 
-            if (!does_topic_exist(event.topic)) {
-                throw std::runtime_error("Topic does not exist to publish.");
+        // Publishes on behalf of a tenant: counts against its quota and lands in its isolated lane if it has one
+        bool publish_event(const TenantTag tenant_tag, const Event& event, const std::string& partition_key = "") {
+            Tenant& tenant = *tenants_[tenant_tag.index];
+            if (!tenant.try_acquire_publish()) {
+                return false; // over quota, dropped like a full queue
+            }
+            return publish_event_to_lane(event, partition_key, tenant.lane_index());
+        }
+
+        [[nodiscard]] TenantTag tenant_tag(const std::string& tenant_name) const {
+            const auto tenant_it = tenant_index_by_name_.find(tenant_name);
+            if (tenant_it == tenant_index_by_name_.end()) {
+                throw std::runtime_error("Tenant - " + tenant_name + " does not exist");
             }
+            return TenantTag{tenant_it->second};
+        }
 
-            auto consumer_groups_by_topic_name_it = consumer_groups_by_topic_name_.find(event.topic);
 
-            if (consumer_groups_by_topic_name_it == consumer_groups_by_topic_name_.end()) {
-                return false; // No consumer groups for this topic, drop message
+        // Hidden group a replicated topic fans out to, drained by ReplicationSender instead of a consumer.
+        // Hidden from consumers_by_consumer_group_id() too.
+        static std::string replication_group_id(const std::string& topic_name) {
+            return "__replication." + topic_name;
+        }
+
+        [[nodiscard]] const std::unordered_map<std::string, std::vector<std::unique_ptr<Consumer>>>& consumers_by_consumer_group_id() const {
+            return consumers_by_consumer_group_id_;
+        }
+
+        // Live ring and payload memory, globally, per topic and per tenant. Cheap enough to poll from a metrics thread.
+        [[nodiscard]] BusMemoryUsage memory_usage() const {
+            BusMemoryUsage usage;
+            usage.total.budget_bytes = memory_budget_bytes_;
+            for (const auto& [topic_name, topic] : topics_) {
+                usage.by_topic[topic_name].budget_bytes = topic.memory_budget_bytes();
+            }
+            for (const auto& tenant : tenants_) {
+                usage.by_tenant[tenant->name()].budget_bytes = tenant->memory_budget_bytes();
             }
+            for_each_lane([&](const std::string& topic_name, const size_t owner_tenant, const PartitionLane& lane) {
+                const size_t ring_bytes = lane.ring_bytes();
+                const size_t payload_bytes = lane.payload_bytes();
+                for (MemoryUsage* scope : {&usage.total, &usage.by_topic[topic_name]}) {
+                    scope->ring_bytes += ring_bytes;
+                    scope->payload_bytes += payload_bytes;
+                }
+                if (owner_tenant != NO_TENANT) {
+                    MemoryUsage& tenant_usage = usage.by_tenant[tenants_[owner_tenant]->name()];
+                    tenant_usage.ring_bytes += ring_bytes;
+                    tenant_usage.payload_bytes += payload_bytes;
+                }
+            });
+            return usage;
+        }
 
-            const std::vector<std::shared_ptr<ConsumerGroup>>& consumer_groups = consumer_groups_by_topic_name_it->second;
+        // Applies a runtime config file while publishers and consumers keep running, see runtime_config.hpp
+        void reload_config(const std::string& path) {
+            apply_runtime_config(parse_runtime_config_file(path));
+        }
 
-            event.id = get_next_message_id_for_topic(event.topic); // ideally we should create a wrapper here on event and store metadata like id on top level of that wrapper
+        // Back-pressure settings are swapped RCU style. Capacity changes migrate the affected partition queues to
+        // new rings: producers switch right away, consumers drain the old ring first so nothing buffered is lost.
+        // The update is validated as a whole before anything is applied.
+        void apply_runtime_config(const RuntimeConfigUpdate& update) {
+            std::lock_guard<std::mutex> lock(reload_mutex_);
+            if (update.back_pressure_strategy && *update.back_pressure_strategy != BackPressureStrategy::BLOCK &&
+                !replication_groups_.empty()) {
+                throw std::runtime_error("Runtime config cannot leave BLOCK back-pressure, the bus has replicated topics");
+            }
 
-            const size_t partition_index = get_partition_index(event.id,
-                    topics_.at(event.topic).partition_count(), partition_key);
+            std::unordered_map<std::string, size_t> new_capacity_by_group;
+            for (const auto& [topic_name, queue_capacity] : update.queue_capacity_by_topic) {
+                if (!does_topic_exist(topic_name)) {
+                    throw std::runtime_error("Runtime config topic - " + topic_name + " does not exist");
+                }
+                validate_queue_capacity(queue_capacity);
+                const auto consumer_groups_it = consumer_groups_by_topic_name_.find(topic_name);
+                if (consumer_groups_it != consumer_groups_by_topic_name_.end()) {
+                    for (const auto& consumer_group : consumer_groups_it->second) {
+                        new_capacity_by_group[consumer_group->group_id()] = queue_capacity;
+                    }
+                }
+            }
+            for (const auto& [group_id, queue_capacity] : update.queue_capacity_by_group) {
+                if (topic_name_by_consumer_group_id_.find(group_id) == topic_name_by_consumer_group_id_.end()) {
+                    throw std::runtime_error("Runtime config consumer group - " + group_id + " does not exist");
+                }
+                validate_queue_capacity(queue_capacity);
+                new_capacity_by_group[group_id] = queue_capacity;
+            }
 
-            bool all_succeeded = true;
-            for (auto& consumer_group : consumer_groups) { // fan out to all groups
-                const bool success = consumer_group-> deliver_event_to_consumer_group(event, partition_index, backpressure_handler_);
-                all_succeeded = all_succeeded && success;
+            std::vector<std::pair<std::shared_ptr<ConsumerGroup>, size_t>> migrations;
+            for (const auto& [topic_name, consumer_groups] : consumer_groups_by_topic_name_) {
+                for (const auto& consumer_group : consumer_groups) {
+                    const auto capacity_it = new_capacity_by_group.find(consumer_group->group_id());
+                    if (capacity_it != new_capacity_by_group.end() && capacity_it->second != consumer_group->queue_capacity()) {
+                        if (consumer_group->has_isolated_lanes()) {
+                            throw std::runtime_error("Runtime config cannot change the queue capacity of consumer group - " +
+                                consumer_group->group_id() + ", its partitions have isolated tenant lanes");
+                        }
+                        migrations.emplace_back(consumer_group, capacity_it->second);
+                    }
+                }
+            }
+            check_migrations_fit_budgets(migrations);
+
+            const BackPressureConfig& current = backpressure_handler_.load()->config();
+            BackPressureConfig back_pressure_config = current;
+            if (update.back_pressure_strategy) back_pressure_config.strategy = *update.back_pressure_strategy;
+            if (update.spin_yield_threshold) back_pressure_config.spin_yield_threshold = *update.spin_yield_threshold;
+            if (update.block_sleep_duration) back_pressure_config.block_sleep_duration = *update.block_sleep_duration;
+            if (update.timeout) back_pressure_config.timeout = *update.timeout;
+            backpressure_handler_.update(std::make_unique<BackPressureHandler>(back_pressure_config));
+
+            for (const auto& [topic_name, queue_capacity] : update.queue_capacity_by_topic) {
+                topics_.at(topic_name).set_queue_capacity(queue_capacity);
+            }
+            for (const auto& [consumer_group, queue_capacity] : migrations) {
+                consumer_group->migrate_partition_queues(queue_capacity);
+            }
+            if (!migrations.empty()) {
+                apply_payload_budgets();
             }
-            return all_succeeded;
         }
 
+        // Grows a topic to partition_count partitions while publishers and consumers keep running. Keys are routed
+        // by jump consistent hashing, so the only keys that move are those that now land in an added partition.
+        // Order per key survives the move: added partitions are fenced, their consumers get nothing out of them
+        // until every old partition of the group has been consumed past the cut taken once no publisher routes with
+        // the old count anymore. Partition counts only grow.
+        void repartition_topic(const std::string& topic_name, const size_t partition_count) {
+            std::lock_guard<std::mutex> lock(reload_mutex_);
+            if (!does_topic_exist(topic_name)) {
+                throw std::runtime_error("Topic - " + topic_name + " does not exist to repartition");
+            }
+            Topic& topic = topics_.at(topic_name);
+            if (topic.has_static_partition_count()) {
+                throw std::runtime_error("Topic - " + topic_name + " has a static partition count and cannot be repartitioned");
+            }
+            const size_t old_partition_count = topic.partition_count();
+            if (partition_count < old_partition_count) {
+                throw std::runtime_error("Topic - " + topic_name + " has " + std::to_string(old_partition_count) +
+                    " partitions, repartitioning can only add partitions");
+            }
+            if (partition_count == old_partition_count) {
+                return;
+            }
 
-        [[nodiscard]] const std::unordered_map<std::string, std::vector<std::unique_ptr<Consumer>>>& consumers_by_consumer_group_id() const {
-            return consumers_by_consumer_group_id_;
+            const auto consumer_groups_it = consumer_groups_by_topic_name_.find(topic_name);
+            std::vector<std::shared_ptr<ConsumerGroup>> consumer_groups;
+            if (consumer_groups_it != consumer_groups_by_topic_name_.end()) {
+                consumer_groups = consumer_groups_it->second;
+            }
+            std::vector<PartitionGrowth> growth;
+            for (const auto& consumer_group : consumer_groups) {
+                growth.push_back({tenant_index_by_consumer_group_id_.at(consumer_group->group_id()), consumer_group->queue_capacity(),
+                    consumer_group->queue_engine()});
+            }
+            check_partitions_fit_budgets("Repartition of topic - " + topic_name, topic, growth,
+                partition_count - old_partition_count);
+
+            // Queues and routes first, publishers index them as soon as they see the new count
+            for (const auto& consumer_group : consumer_groups) {
+                consumer_group->add_partitions(partition_count);
+            }
+            update_topic_routes(topic);
+            topic.set_partition_count(partition_count);
+            topic.routing_grace_period().synchronize();
+            for (const auto& consumer_group : consumer_groups) {
+                consumer_group->fence_added_partitions(old_partition_count);
+            }
+            apply_payload_budgets();
+        }
+
+        [[nodiscard]] BackPressureConfig back_pressure_config() const {
+            return backpressure_handler_.load()->config();
+        }
+
+        // Captures undelivered events of every partition plus group cursors and topic id and sequence counters.
+        // Publishers and consumers must be stopped while this runs, it does not consume anything.
+        [[nodiscard]] BusSnapshot capture_snapshot() const {
+            ReplicationDrainPause drain_pause(*this);
+            BusSnapshot snapshot;
+            for (const auto& [topic_name, topic] : topics_) {
+                if (topic.message_id_watermark() != 0 || topic.sequence_watermark() != 1) {
+                    snapshot.topics.push_back({topic_name, topic.message_id_watermark(), topic.sequence_watermark()});
+                }
+            }
+            for (const auto& [topic_name, consumer_groups] : consumer_groups_by_topic_name_) {
+                for (const auto& consumer_group : consumer_groups) {
+                    snapshot.consumer_groups.push_back({consumer_group->group_id(), topic_name,
+                        consumer_group->snapshot_partitions()});
+                }
+            }
+            return snapshot;
+        }
+
+        // Reloads a snapshot into this freshly constructed bus before any publisher or consumer starts.
+        // Topology must match: every snapshotted group has to exist with the same topic and partition count.
+        void restore_snapshot(const BusSnapshot& snapshot) {
+            ReplicationDrainPause drain_pause(*this);
+            for (const auto& topic : snapshot.topics) {
+                if (!does_topic_exist(topic.name)) {
+                    throw std::runtime_error("Snapshot topic - " + topic.name + " does not exist");
+                }
+                topics_.at(topic.name).advance_message_id_watermark(topic.next_message_id);
+                topics_.at(topic.name).advance_sequence_watermark(topic.next_sequence);
+            }
+            for (const auto& group : snapshot.consumer_groups) {
+                const auto topic_it = topic_name_by_consumer_group_id_.find(group.group_id);
+                if (topic_it == topic_name_by_consumer_group_id_.end() || topic_it->second != group.topic_name) {
+                    throw std::runtime_error("Snapshot consumer group - " + group.group_id + " does not exist for topic - " + group.topic_name);
+                }
+                // Restored events go in like published ones, inside the topic's producer guard
+                const GracePeriod::ReadGuard routing_guard(topics_.at(group.topic_name).routing_grace_period());
+                for (const auto& consumer_group : consumer_groups_by_topic_name_.at(group.topic_name)) {
+                    if (consumer_group->group_id() == group.group_id) {
+                        consumer_group->restore_partitions(group.partitions);
+                    }
+                }
+            }
+        }
+
+        void save_snapshot(const std::string& path) const {
+            write_snapshot_file(capture_snapshot(), path);
+        }
+
+        void load_snapshot(const std::string& path) {
+            restore_snapshot(read_snapshot_file(path));
         }
 
     private:
+        static constexpr size_t NO_TENANT = SIZE_MAX;
+
+        // Partitions about to be allocated for one consumer group
+        struct PartitionGrowth {
+            size_t owner_tenant;
+            size_t queue_capacity; // of the shared lane
+            QueueEngine queue_engine; // of the group, not always the topic's
+        };
+
+        // Ring bytes per budget scope
+        struct RingBytes {
+            size_t total = 0;
+            std::unordered_map<std::string, size_t> by_topic;
+            std::vector<size_t> by_tenant;
+
+            explicit RingBytes(const size_t tenant_count) : by_tenant(tenant_count, 0) {}
+
+            void add(const RingBytes& other) {
+                total += other.total;
+                for (const auto& [topic_name, bytes] : other.by_topic) {
+                    by_topic[topic_name] += bytes;
+                }
+                for (size_t tenant_index = 0; tenant_index < by_tenant.size(); ++tenant_index) {
+                    by_tenant[tenant_index] += other.by_tenant[tenant_index];
+                }
+            }
+        };
+
         std::unordered_map<std::string, Topic> topics_;
         std::unordered_map<std::string, std::vector<std::shared_ptr<ConsumerGroup>>> consumer_groups_by_topic_name_;
-        std::unordered_map<std::string, std::atomic<size_t>> message_id_by_topic_name_;
         std::unordered_map<std::string, std::string> topic_name_by_consumer_group_id_;
         std::unordered_map<std::string, std::vector<std::unique_ptr<Consumer>>> consumers_by_consumer_group_id_;
-        BackPressureHandler backpressure_handler_;
+        std::vector<std::unique_ptr<Tenant>> tenants_;
+        std::unordered_map<std::string, size_t> tenant_index_by_name_;
+        std::unordered_map<std::string, size_t> tenant_index_by_consumer_group_id_;
+        std::vector<size_t> tenant_index_by_lane_{NO_TENANT}; // lane 0 is shared, isolated tenants follow
+        std::vector<size_t> isolated_lane_capacities_; // capacities of lanes 1..n
+        // Lanes 1..n with a ring in the partition queues of a topic, queue lane i + 1 holds entry i
+        std::unordered_map<std::string, std::vector<size_t>> isolated_lanes_by_topic_name_;
+        RcuPtr<BackPressureHandler> backpressure_handler_; // swapped by reloads, publishers never block on it
+        size_t memory_budget_bytes_;
+        std::mutex reload_mutex_;
+        std::vector<ConsumerGroup*> replication_groups_; // hidden groups of replicated topics
+        std::vector<std::unique_ptr<Consumer>> replication_consumers_; // never polled, see the constructor
+        // The drain is paused by snapshots too, which are const
+        mutable std::mutex replication_drain_mutex_; // hands the replication groups between the drain and a sender
+        bool replication_sender_attached_{false}; // guarded by replication_drain_mutex_
+        mutable std::atomic<bool> replication_drain_stopping_{false};
+        mutable std::thread replication_drain_;
+
+        bool publish_event_to_lane(const Event& event, const std::string& partition_key, const size_t lane_index) {
+            return publish_to_topic(topic_for_publish(event.topic), event, partition_key, lane_index);
+        }
+
+        // StaticPartitionCount is the partition count of a topic that can never be repartitioned, known at compile
+        // time, so the round robin modulo is done by a constant. 0 reads the topic's current count.
+        template<size_t StaticPartitionCount = 0>
+        bool publish_to_topic(Topic& topic, const Event& event, const std::string& partition_key, const size_t lane_index) {
+            const GracePeriod::ReadGuard routing_guard(topic.routing_grace_period()); // until the event is enqueued
+            size_t partition_index = 0;
+            if (!assign_event_partition<StaticPartitionCount>(topic, event, partition_key, lane_index, partition_index)) {
+                return false;
+            }
+            if (topic.total_order()) {
+                event.sequence = topic.reserve_sequences(1);
+            }
+            const TopicRoutes& routes = topic.routes();
+            PartitionLane* const* group_lanes = routes.group_lanes(partition_index, lane_index);
+
+            const BackPressureHandler& backpressure_handler = *backpressure_handler_.load();
+            const std::unique_lock<std::mutex> fan_out_lock = routes.lock_fan_out(partition_index, lane_index);
+            bool all_succeeded = true;
+            for (size_t group_index = 0; group_index < routes.group_count; ++group_index) { // fan out to all groups
+                const bool success = backpressure_handler.try_enqueue_with_backpressure_strategy(group_lanes[group_index], event);
+                all_succeeded = all_succeeded && success;
+            }
+            return all_succeeded;
+        }
+
+        Topic& topic_for_publish(const std::string& topic_name) {
+            const auto topic_it = topics_.find(topic_name);
+            if (topic_it == topics_.end()) {
+                throw std::runtime_error("Topic does not exist to publish.");
+            }
+            return topic_it->second;
+        }
+
+        // Gives the event its id and picks its partition. False when nobody consumes the topic.
+        // The caller holds a read guard on the topic's routing grace period until the event is enqueued.
+        template<size_t StaticPartitionCount = 0>
+        bool assign_event_partition(Topic& topic, const Event& event, const std::string& partition_key,
+            const size_t lane_index, size_t& partition_index) {
+            if (topic.routes().group_count == 0) {
+                return false; // No consumer groups for this topic, drop message
+            }
+
+            event.id = topic.next_message_id(); // ideally we should create a wrapper here on event and store metadata like id on top level of that wrapper
 
-        void create_topic(const std::string& topic_name, const size_t partition_count) {
-            if (does_topic_exist(topic_name)) {
+            std::string_view key = partition_key;
+            if (key.empty()) {
+                topic.extract_partition_key(event.payload, key); // hashes like the same key passed explicitly
+            }
+            event.key_hash = get_key_hash(key);
+            const size_t partition_count = StaticPartitionCount != 0 ? StaticPartitionCount : topic.partition_count();
+            if (event.key_hash == Event::NO_KEY && topic.keyless_partitioning() == KeylessPartitioning::LEAST_LOADED) {
+                partition_index = least_loaded_partition(topic, event.id, partition_count, lane_index);
+            } else {
+                partition_index = get_partition_index(event.id, partition_count, event.key_hash);
+            }
+            return true;
+        }
+
+        // Power of two choices: the round robin pick against a second partition spread by a multiplicative hash of
+        // the id, the shallower lane wins and ties keep the round robin pick. Two depth reads per group instead of
+        // a scan of every partition, and random enough that publishers do not all pile onto the same emptiest one.
+        static size_t least_loaded_partition(const Topic& topic, const size_t event_id, const size_t partition_count,
+            const size_t lane_index) {
+            const size_t first = event_id % partition_count;
+            if (partition_count == 1) {
+                return first;
+            }
+            size_t second = static_cast<size_t>((static_cast<uint64_t>(event_id) * 0x9E3779B97F4A7C15ULL) >> 32) %
+                (partition_count - 1);
+            second = second >= first ? second + 1 : second; // never first itself
+            const TopicRoutes& routes = topic.routes(); // covers partition_count, see Topic::routes
+            return partition_depth(routes, second, lane_index) < partition_depth(routes, first, lane_index) ? second : first;
+        }
+
+        // Deepest lane across the groups, the group furthest behind is the one that drops or blocks first
+        static size_t partition_depth(const TopicRoutes& routes, const size_t partition_index, const size_t lane_index) {
+            PartitionLane* const* group_lanes = routes.group_lanes(partition_index, lane_index);
+            size_t depth = 0;
+            for (size_t group_index = 0; group_index < routes.group_count; ++group_index) {
+                depth = std::max(depth, group_lanes[group_index]->depth_approx());
+            }
+            return depth;
+        }
+
+        // Fans a run of events that already went through assign_event_partition out to every group of the topic,
+        // under the same routing read guard. Each lane gets one batched ring claim, back-pressure only applies to
+        // what did not fit.
+        bool deliver_batch(const Topic& topic, const size_t partition_index, const size_t lane_index,
+            const std::vector<Event>& events) {
+            const TopicRoutes& routes = topic.routes();
+            PartitionLane* const* group_lanes = routes.group_lanes(partition_index, lane_index);
+
+            const BackPressureHandler& backpressure_handler = *backpressure_handler_.load();
+            const std::unique_lock<std::mutex> fan_out_lock = routes.lock_fan_out(partition_index, lane_index);
+            bool all_succeeded = true;
+            for (size_t group_index = 0; group_index < routes.group_count; ++group_index) {
+                PartitionLane* lane = group_lanes[group_index];
+                size_t delivered = lane->enqueue_batch(events.data(), events.size());
+                for (size_t i = delivered; i < events.size(); ++i) {
+                    if (backpressure_handler.try_enqueue_with_backpressure_strategy(lane, events[i])) {
+                        ++delivered;
+                    }
+                }
+                all_succeeded = all_succeeded && delivered == events.size();
+            }
+            return all_succeeded;
+        }
+
+        void create_topic(const TopicConfig& topic_config) {
+            if (does_topic_exist(topic_config.name)) {
                 throw std::runtime_error("Topic already exists.");
             }
-            topics_.emplace(topic_name, Topic(topic_name, partition_count));
+            if (topic_config.queue_engine == QueueEngine::BROADCAST_RING) {
+                throw std::runtime_error("Topic - " + topic_config.name +
+                    " cannot pick BROADCAST_RING, broadcast is set per consumer group");
+            }
+            topics_.try_emplace(topic_config.name, topic_config.name, topic_config.partition_count,
+                topic_config.queue_capacity, topic_config.memory_budget_bytes, topic_config.queue_engine,
+                RingAllocation{topic_config.initial_queue_capacity, topic_config.allocate_queues_on_first_use},
+                topic_config.static_partition_count, topic_config.keyless_partitioning, topic_config.partition_key_field,
+                topic_config.total_order, topic_config.replicated);
         }
 
-        std::shared_ptr<ConsumerGroup> create_consumer_group(const std::string& group_id, const std::string& topic_name, const size_t consumer_group_size) {
+        void create_tenant(const TenantConfig& tenant_config) {
+            if (tenant_index_by_name_.find(tenant_config.name) != tenant_index_by_name_.end()) {
+                throw std::runtime_error("Tenant - " + tenant_config.name + " already exists");
+            }
+            if ((tenant_config.isolated_queue_capacity != 0) != !tenant_config.isolated_topics.empty()) {
+                throw std::runtime_error("Tenant - " + tenant_config.name +
+                    " needs both an isolated queue capacity and isolated topics, or neither");
+            }
+            for (const std::string& topic_name : tenant_config.isolated_topics) {
+                if (!does_topic_exist(topic_name)) {
+                    throw std::runtime_error("Topic - " + topic_name + " does not exist for tenant - " + tenant_config.name);
+                }
+            }
+            const size_t tenant_index = tenants_.size();
+            auto tenant = std::make_unique<Tenant>(tenant_config.name, tenant_config.max_publish_events_per_window,
+                tenant_config.publish_quota_window, tenant_config.isolated_queue_capacity, tenant_config.memory_budget_bytes);
+            if (tenant_config.isolated_queue_capacity != 0) {
+                // Only the topics it publishes to get its lanes, nobody else's groups pay for them
+                const size_t lane_index = tenant_index_by_lane_.size();
+                tenant->set_lane_index(lane_index);
+                tenant_index_by_lane_.push_back(tenant_index);
+                isolated_lane_capacities_.push_back(tenant_config.isolated_queue_capacity);
+                for (const std::string& topic_name : tenant_config.isolated_topics) {
+                    std::vector<size_t>& topic_lanes = isolated_lanes_by_topic_name_[topic_name];
+                    if (std::find(topic_lanes.begin(), topic_lanes.end(), lane_index) == topic_lanes.end()) {
+                        topic_lanes.push_back(lane_index);
+                    }
+                }
+            }
+            tenant_index_by_name_[tenant_config.name] = tenant_index;
+            tenants_.push_back(std::move(tenant));
+        }
+
+        // Registers the group and its consumers and books its rings into reserved. Allocating the rings, handing
+        // partitions to consumers and routing the topic to the group are left to the caller, see the constructor.
+        // A broadcast group books the same rings as a queueing one, its consumers share them.
+        std::shared_ptr<ConsumerGroup> create_consumer_group(const std::string& group_id, const std::string& topic_name,
+            const size_t consumer_group_size, const std::string& tenant_name, const bool broadcast, const bool acknowledged,
+            RingBytes& reserved) {
             if (!does_topic_exist(topic_name)) {
                 throw std::runtime_error("Topic - " + topic_name +   " doest not exist for consumer group - " + group_id);
             }
             if (topic_name_by_consumer_group_id_.find(group_id) != topic_name_by_consumer_group_id_.end()) {
                 throw std::runtime_error("Consumer group - " + group_id + " already assigned to topic - " + topic_name_by_consumer_group_id_.at(group_id));
             }
+            const size_t owner_tenant = tenant_name.empty() ? NO_TENANT : tenant_tag(tenant_name).index;
+
+            const Topic& topic = topics_.at(topic_name);
+            const QueueEngine queue_engine = broadcast || acknowledged ? QueueEngine::BROADCAST_RING : topic.queue_engine();
+            // Refuse the group up front rather than allocating rings that would break a budget
+            const RingBytes required = required_ring_bytes(topic, {{owner_tenant, topic.queue_capacity(), queue_engine}},
+                topic.partition_count());
+            check_ring_bytes_fit_budgets("Consumer group - " + group_id, topic, reserved, required);
+            reserved.add(required);
 
+            std::vector<size_t> lane_capacities;
+            for (const size_t lane_index : isolated_lanes(topic_name)) {
+                lane_capacities.push_back(isolated_lane_capacities_[lane_index - 1]);
+            }
             const auto consumer_group = std::make_shared<ConsumerGroup>(group_id,
-                topics_.at(topic_name).partition_count());
+                topic.partition_count(), topic.queue_capacity(), std::move(lane_capacities), topic.queue_engine(),
+                topic.ring_allocation(), broadcast, acknowledged);
 
             consumer_groups_by_topic_name_[topic_name].push_back(consumer_group);
 
             topic_name_by_consumer_group_id_[group_id] = topic_name;
+            tenant_index_by_consumer_group_id_[group_id] = owner_tenant;
 
             for (size_t i = 0; i < consumer_group_size; ++i) {
                 auto consumer = std::make_unique<Consumer>(*consumer_group);
                 consumers_by_consumer_group_id_[group_id].push_back(std::move(consumer));
             }
-            consumer_group->create_partition_assignments_among_consumers_();
             return consumer_group;
         }
 
-        bool does_topic_exist(const std::string &topic_name) {
+        // Rebuilds the publish routes of a topic from the partition queues of its groups, control plane only
+        void update_topic_routes(Topic& topic) {
+            auto routes = std::make_unique<TopicRoutes>();
+            const auto consumer_groups_it = consumer_groups_by_topic_name_.find(topic.name());
+            if (consumer_groups_it != consumer_groups_by_topic_name_.end()) {
+                const auto& consumer_groups = consumer_groups_it->second;
+                const size_t partition_count = consumer_groups.front()->partition_queues().size();
+                routes->lane_count = tenant_index_by_lane_.size();
+                routes->group_count = consumer_groups.size();
+                routes->lanes.resize(partition_count * routes->lane_count * routes->group_count);
+                // Tenants isolated on other topics only publish into the shared lane here
+                std::vector<size_t> queue_lane_by_lane(routes->lane_count, 0);
+                const std::vector<size_t>& topic_lanes = isolated_lanes(topic.name());
+                for (size_t queue_lane = 1; queue_lane <= topic_lanes.size(); ++queue_lane) {
+                    queue_lane_by_lane[topic_lanes[queue_lane - 1]] = queue_lane;
+                }
+                if (topic.replicated()) {
+                    const size_t queue_lane_count = topic_lanes.size() + 1;
+                    routes->fan_out_locks.resize(partition_count * routes->lane_count);
+                    for (size_t partition_index = 0; partition_index < partition_count; ++partition_index) {
+                        for (size_t lane_index = 0; lane_index < routes->lane_count; ++lane_index) {
+                            routes->fan_out_locks[partition_index * routes->lane_count + lane_index] =
+                                topic.fan_out_lock(partition_index * queue_lane_count + queue_lane_by_lane[lane_index]);
+                        }
+                    }
+                }
+                for (size_t group_index = 0; group_index < consumer_groups.size(); ++group_index) {
+                    const auto& partition_queues = consumer_groups[group_index]->partition_queues();
+                    for (size_t partition_index = 0; partition_index < partition_count; ++partition_index) {
+                        for (size_t lane_index = 0; lane_index < routes->lane_count; ++lane_index) {
+                            routes->lanes[(partition_index * routes->lane_count + lane_index) * routes->group_count +
+                                group_index] = partition_queues[partition_index]->lane(queue_lane_by_lane[lane_index]);
+                        }
+                    }
+                }
+            }
+            topic.set_routes(std::move(routes));
+        }
+
+        // Visits every lane of every partition queue with its topic and owning tenant. Lane 0 belongs to the tenant
+        // owning the group (if any), other lanes to the isolated tenant publishing into them.
+        template<typename Visitor>
+        void for_each_lane(Visitor&& visitor) const {
+            for (const auto& [topic_name, consumer_groups] : consumer_groups_by_topic_name_) {
+                const std::vector<size_t>& topic_lanes = isolated_lanes(topic_name);
+                for (const auto& consumer_group : consumer_groups) {
+                    const size_t group_tenant = tenant_index_by_consumer_group_id_.at(consumer_group->group_id());
+                    for (const auto& partition_queue : consumer_group->partition_queues()) {
+                        for (size_t lane_index = 0; lane_index < partition_queue->lane_count(); ++lane_index) {
+                            const size_t owner_tenant = lane_index == 0 ? group_tenant :
+                                tenant_index_by_lane_[topic_lanes[lane_index - 1]];
+                            visitor(topic_name, owner_tenant, *partition_queue->lane(lane_index));
+                        }
+                    }
+                }
+            }
+        }
+
+        // Lanes 1..n isolated on a topic, in the order of its queue lanes from 1
+        [[nodiscard]] const std::vector<size_t>& isolated_lanes(const std::string& topic_name) const {
+            static const std::vector<size_t> no_lanes;
+            const auto lanes_it = isolated_lanes_by_topic_name_.find(topic_name);
+            return lanes_it != isolated_lanes_by_topic_name_.end() ? lanes_it->second : no_lanes;
+        }
+
+        // What the lanes allocated so far reserve, see PartitionLane::reserved_ring_bytes
+        [[nodiscard]] RingBytes reserved_ring_bytes() const {
+            RingBytes reserved(tenants_.size());
+            for_each_lane([&](const std::string& topic_name, const size_t lane_owner, const PartitionLane& lane) {
+                const size_t lane_bytes = lane.reserved_ring_bytes();
+                reserved.total += lane_bytes;
+                reserved.by_topic[topic_name] += lane_bytes;
+                if (lane_owner != NO_TENANT) {
+                    reserved.by_tenant[lane_owner] += lane_bytes;
+                }
+            });
+            return reserved;
+        }
+
+        // What partition_count new partitions in each of the given groups of the topic would reserve
+        [[nodiscard]] RingBytes required_ring_bytes(const Topic& topic, const std::vector<PartitionGrowth>& groups,
+            const size_t partition_count) const {
+            RingBytes required(tenants_.size());
+            for (const PartitionGrowth& group : groups) {
+                const size_t shared_lane_bytes = partition_count * PartitionLane::reserved_ring_bytes_for(
+                    group.queue_engine, group.queue_capacity, topic.ring_allocation().initial_capacity);
+                required.total += shared_lane_bytes;
+                if (group.owner_tenant != NO_TENANT) {
+                    required.by_tenant[group.owner_tenant] += shared_lane_bytes;
+                }
+                for (const size_t lane_index : isolated_lanes(topic.name())) {
+                    const size_t lane_bytes = partition_count * EventRing::memory_bytes_for_capacity(
+                        group.queue_engine, isolated_lane_capacities_[lane_index - 1]);
+                    required.total += lane_bytes;
+                    required.by_tenant[tenant_index_by_lane_[lane_index]] += lane_bytes;
+                }
+            }
+            required.by_topic[topic.name()] = required.total;
+            return required;
+        }
+
+        // Refuse partitions up front rather than allocating rings that would break a budget
+        void check_partitions_fit_budgets(const std::string& subject, const Topic& topic,
+            const std::vector<PartitionGrowth>& groups, const size_t partition_count) const {
+            check_ring_bytes_fit_budgets(subject, topic, reserved_ring_bytes(),
+                required_ring_bytes(topic, groups, partition_count));
+        }
+
+        void check_ring_bytes_fit_budgets(const std::string& subject, const Topic& topic, const RingBytes& reserved,
+            const RingBytes& required) const {
+            const auto topic_bytes_it = reserved.by_topic.find(topic.name());
+            const size_t topic_bytes = topic_bytes_it != reserved.by_topic.end() ? topic_bytes_it->second : 0;
+            if (topic.memory_budget_bytes() != 0 && topic_bytes + required.total > topic.memory_budget_bytes()) {
+                throw std::runtime_error(subject + " exceeds memory budget of topic - " + topic.name());
+            }
+            if (memory_budget_bytes_ != 0 && reserved.total + required.total > memory_budget_bytes_) {
+                throw std::runtime_error(subject + " exceeds memory budget of the event bus");
+            }
+            for (size_t tenant_index = 0; tenant_index < tenants_.size(); ++tenant_index) {
+                const size_t budget = tenants_[tenant_index]->memory_budget_bytes();
+                if (budget != 0 && required.by_tenant[tenant_index] != 0 &&
+                    reserved.by_tenant[tenant_index] + required.by_tenant[tenant_index] > budget) {
+                    throw std::runtime_error(subject + " exceeds memory budget of tenant - " + tenants_[tenant_index]->name());
+                }
+            }
+        }
+
+        static void validate_queue_capacity(const size_t queue_capacity) {
+            if (queue_capacity < EventRing::MIN_CAPACITY || (queue_capacity & (queue_capacity - 1)) != 0) {
+                throw std::runtime_error("Queue capacity must be a power of two of at least " +
+                    std::to_string(EventRing::MIN_CAPACITY) + ", got " + std::to_string(queue_capacity));
+            }
+        }
+
+        // Migrated rings come on top of the current ones, the old rings stay allocated until their readers drained them
+        void check_migrations_fit_budgets(const std::vector<std::pair<std::shared_ptr<ConsumerGroup>, size_t>>& migrations) const {
+            size_t total_bytes = 0;
+            std::unordered_map<std::string, size_t> topic_bytes;
+            std::vector<size_t> tenant_bytes(tenants_.size(), 0);
+            for_each_lane([&](const std::string& topic_name, const size_t owner_tenant, const PartitionLane& lane) {
+                total_bytes += lane.reserved_ring_bytes();
+                topic_bytes[topic_name] += lane.reserved_ring_bytes();
+                if (owner_tenant != NO_TENANT) {
+                    tenant_bytes[owner_tenant] += lane.reserved_ring_bytes();
+                }
+            });
+
+            for (const auto& [consumer_group, queue_capacity] : migrations) {
+                const std::string& topic_name = topic_name_by_consumer_group_id_.at(consumer_group->group_id());
+                const size_t owner_tenant = tenant_index_by_consumer_group_id_.at(consumer_group->group_id());
+                const size_t added_bytes = consumer_group->partition_count() *
+                    EventRing::memory_bytes_for_capacity(consumer_group->queue_engine(), queue_capacity);
+                total_bytes += added_bytes;
+                topic_bytes[topic_name] += added_bytes;
+
+                const size_t topic_budget = topics_.at(topic_name).memory_budget_bytes();
+                if (topic_budget != 0 && topic_bytes[topic_name] > topic_budget) {
+                    throw std::runtime_error("Queue migration of consumer group - " + consumer_group->group_id() +
+                        " exceeds memory budget of topic - " + topic_name);
+                }
+                if (owner_tenant != NO_TENANT) {
+                    tenant_bytes[owner_tenant] += added_bytes;
+                    const size_t tenant_budget = tenants_[owner_tenant]->memory_budget_bytes();
+                    if (tenant_budget != 0 && tenant_bytes[owner_tenant] > tenant_budget) {
+                        throw std::runtime_error("Queue migration of consumer group - " + consumer_group->group_id() +
+                            " exceeds memory budget of tenant - " + tenants_[owner_tenant]->name());
+                    }
+                }
+            }
+            if (memory_budget_bytes_ != 0 && total_bytes > memory_budget_bytes_) {
+                throw std::runtime_error("Queue migration exceeds memory budget of the event bus");
+            }
+        }
+
+        // Whatever budget is left after the rings is split evenly over every lane it covers, so the publish path
+        // only checks a lane local limit instead of contending on a shared counter. A lane covered by several
+        // budgets (bus, topic, tenant) gets the smallest share.
+        void apply_payload_budgets() {
+            struct BudgetScope {
+                size_t budget_bytes{};
+                size_t ring_bytes{};
+                size_t lane_count{};
+
+                [[nodiscard]] size_t share() const {
+                    if (budget_bytes == 0 || lane_count == 0) {
+                        return 0;
+                    }
+                    const size_t remaining = budget_bytes > ring_bytes ? budget_bytes - ring_bytes : 0;
+                    return std::max<size_t>(remaining / lane_count, 1); // 1 byte still refuses any payload
+                }
+            };
+
+            BudgetScope total{memory_budget_bytes_};
+            std::unordered_map<std::string, BudgetScope> by_topic;
+            std::vector<BudgetScope> by_tenant(tenants_.size());
+            for (const auto& [topic_name, topic] : topics_) {
+                by_topic[topic_name].budget_bytes = topic.memory_budget_bytes();
+            }
+            for (size_t tenant_index = 0; tenant_index < tenants_.size(); ++tenant_index) {
+                by_tenant[tenant_index].budget_bytes = tenants_[tenant_index]->memory_budget_bytes();
+            }
+
+            for_each_lane([&](const std::string& topic_name, const size_t owner_tenant, const PartitionLane& lane) {
+                std::vector<BudgetScope*> scopes{&total, &by_topic[topic_name]};
+                if (owner_tenant != NO_TENANT) {
+                    scopes.push_back(&by_tenant[owner_tenant]);
+                }
+                for (BudgetScope* scope : scopes) {
+                    scope->ring_bytes += lane.reserved_ring_bytes();
+                    ++scope->lane_count;
+                }
+            });
+
+            for_each_lane([&](const std::string& topic_name, const size_t owner_tenant, PartitionLane& lane) {
+                size_t limit = 0;
+                const size_t shares[] = {
+                    total.share(),
+                    by_topic[topic_name].share(),
+                    owner_tenant != NO_TENANT ? by_tenant[owner_tenant].share() : 0
+                };
+                for (const size_t share : shares) {
+                    if (share != 0 && (limit == 0 || share < limit)) {
+                        limit = share;
+                    }
+                }
+                lane.set_payload_limit_bytes(limit);
+            });
+        }
+
+        // A replicated topic fills its replication group like any other. While no ReplicationSender drains it, this
+        // thread discards what lands there, so publishers never block on a standby nobody ships to.
+        void start_replication_drain() const {
+            if (replication_groups_.empty()) {
+                return;
+            }
+            replication_drain_stopping_.store(false, std::memory_order_release);
+            replication_drain_ = std::thread([this] { run_replication_drain(); });
+        }
+
+        void stop_replication_drain() const {
+            replication_drain_stopping_.store(true, std::memory_order_release);
+            if (replication_drain_.joinable()) {
+                replication_drain_.join();
+            }
+        }
+
+        void run_replication_drain() const {
+            constexpr size_t DRAIN_BATCH_EVENTS = 1024;
+            constexpr std::chrono::microseconds DRAIN_IDLE_SLEEP{100};
+            std::vector<Event> discarded;
+            while (!replication_drain_stopping_.load(std::memory_order_acquire)) {
+                size_t drained = 0;
+                for (const ConsumerGroup* replication_group : replication_groups_) {
+                    for (const auto& partition_queue : replication_group->partition_queues()) {
+                        for (size_t lane_index = 0; lane_index < partition_queue->lane_count(); ++lane_index) {
+                            discarded.clear();
+                            drained += partition_queue->lane(lane_index)->dequeue_batch(discarded, DRAIN_BATCH_EVENTS, 0);
+                        }
+                    }
+                }
+                if (drained == 0) {
+                    std::this_thread::sleep_for(DRAIN_IDLE_SLEEP);
+                }
+            }
+        }
+
+        // Keeps the drain off the replication groups for a scope
+        class ReplicationDrainPause {
+        public:
+            explicit ReplicationDrainPause(const EventBus& event_bus)
+                : event_bus_(event_bus), lock_(event_bus.replication_drain_mutex_) {
+                event_bus_.stop_replication_drain();
+            }
+
+            ~ReplicationDrainPause() {
+                if (!event_bus_.replication_sender_attached_) {
+                    event_bus_.start_replication_drain();
+                }
+            }
+
+        private:
+            const EventBus& event_bus_;
+            std::lock_guard<std::mutex> lock_;
+        };
+
+        // ReplicationSender takes the replication groups over from the drain, one sender at a time
+        void attach_replication_sender() {
+            std::lock_guard<std::mutex> lock(replication_drain_mutex_);
+            if (replication_sender_attached_) {
+                throw std::runtime_error("Replication - another sender is already attached to this bus");
+            }
+            stop_replication_drain();
+            replication_sender_attached_ = true;
+        }
+
+        void detach_replication_sender() {
+            std::lock_guard<std::mutex> lock(replication_drain_mutex_);
+            replication_sender_attached_ = false;
+            start_replication_drain();
+        }
+
+        bool does_topic_exist(const std::string &topic_name) const {
             if (topics_.find(topic_name) != topics_.end()) {
                 return true;
             }
             return false;
         }
 
-        static size_t get_partition_index(const size_t event_id, const size_t partition_count,
-            const std::string& partition_key) {
+        // Kept on the event so consumers can fan a partition out per key, never NO_KEY for a real key
+        static size_t get_key_hash(const std::string_view partition_key) {
             if (partition_key.empty()) {
+                return Event::NO_KEY;
+            }
+            const size_t key_hash = std::hash<std::string_view>{}(partition_key);
+            return key_hash == Event::NO_KEY ? 1 : key_hash;
+        }
+
+        static size_t get_partition_index(const size_t event_id, const size_t partition_count, const size_t key_hash) {
+            if (key_hash == Event::NO_KEY) {
                 return event_id % partition_count; // round robin
             }
-            return std::hash<std::string>{}(partition_key) % partition_count; // key based hashing
+            return jump_consistent_hash(key_hash, partition_count); // key based hashing
         }
 
-        size_t get_next_message_id_for_topic(const std::string& topic_name) {
-            return message_id_by_topic_name_[topic_name].fetch_add(1, std::memory_order_relaxed);
+        // Lamping & Veach jump consistent hash. When the bucket count grows, a key either stays where it was or
+        // moves to one of the new buckets, never between old ones, which is what keeps repartitioning cheap.
+        static size_t jump_consistent_hash(uint64_t key, const size_t bucket_count) {
+            int64_t bucket = -1;
+            int64_t next = 0;
+            while (next < static_cast<int64_t>(bucket_count)) {
+                bucket = next;
+                key = key * 2862933555777941757ULL + 1;
+                next = static_cast<int64_t>(static_cast<double>(bucket + 1) *
+                    (static_cast<double>(int64_t{1} << 31) / static_cast<double>((key >> 33) + 1)));
+            }
+            return static_cast<size_t>(bucket);
         }
     };
 }
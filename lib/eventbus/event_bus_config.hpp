@@ -1,21 +1,56 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "event_ring.hpp"
+
 namespace eventbus {
+    // Where events published without a partition key go
+    enum class KeylessPartitioning {
+        ROUND_ROBIN,  // by message id, blind to how full the partitions are
+        LEAST_LOADED  // the shallower of two candidate partitions, steers around stalled consumers
+    };
+
     struct TopicConfig {
         std::string name;
         size_t partition_count;
+        size_t queue_capacity = 16384; // slots per partition queue of every subscribed group, power of two, at least 2
+        size_t memory_budget_bytes = 0; // ring + payload bytes across all groups of this topic, 0 = unlimited
+        QueueEngine queue_engine = QueueEngine::CAS_RING; // FETCH_ADD_RING for many producers, RELAXED_RING if order does not matter
+        size_t initial_queue_capacity = 0; // rings start this small (at least 2) and double when full up to queue_capacity, 0 = start full size
+        bool allocate_queues_on_first_use = false; // no ring memory until a partition sees its first event
+        bool static_partition_count = false; // compiled into publishers (see StaticTopology), refuses repartitioning
+        KeylessPartitioning keyless_partitioning = KeylessPartitioning::ROUND_ROBIN;
+        std::string partition_key_field{}; // JSON payload field ("a.b" when nested) keying events published without a key, empty = off
+        bool total_order = false; // stamps events with a topic wide sequence, see MergeOrder::SEQUENCE
+        bool replicated = false; // mirrored to a standby through a hidden consumer group, needs BLOCK back-pressure, see ReplicationSender
     };
 
     struct ConsumerGroupConfig {
         std::string group_id;
         std::string topic_name;
         size_t consumer_count;
+        std::string tenant{}; // owning tenant, empty for none
+        bool broadcast = false; // every consumer gets every partition, all reading one shared ring per lane
+        bool acknowledged = false; // at least once: slots stay reserved until acknowledged, see Consumer::acknowledge
+    };
+
+    struct TenantConfig {
+        std::string name;
+        uint32_t max_publish_events_per_window = 0; // publish quota, 0 = unlimited
+        std::chrono::nanoseconds publish_quota_window = std::chrono::seconds(1);
+        size_t isolated_queue_capacity = 0; // own lane of this size in the partition queues of isolated_topics, 0 = share lane 0
+        size_t memory_budget_bytes = 0; // rings + payload of its groups and isolated lanes, 0 = unlimited
+        std::vector<std::string> isolated_topics; // topics it publishes to, the only ones that get (and charge) its lanes
     };
+
     struct EventBusConfig {
         std::vector<TopicConfig> topics;
         std::vector<ConsumerGroupConfig> consumer_groups;
-
+        std::vector<TenantConfig> tenants{};
+        size_t memory_budget_bytes = 0; // ring + payload bytes across the whole bus, 0 = unlimited
+        size_t startup_threads = 0; // threads building partition rings in the constructor, 0 = one per core
     };
 }
\ No newline at end of file
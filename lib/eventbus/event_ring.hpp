@@ -0,0 +1,206 @@
+#pragma once
+#include <variant>
+
+#include "broadcast_queue.hpp"
+#include "event.hpp"
+#include "fetch_add_mpsc_queue.hpp"
+#include "lock_free_mpsc_queue.hpp"
+#include "relaxed_mpsc_queue.hpp"
+
+namespace eventbus {
+    enum class QueueEngine {
+        CAS_RING,        // LockFreeMpscQueue, CAS slot claiming, cheapest with few producers
+        FETCH_ADD_RING,  // FetchAddMpscQueue, fetch_add slot claiming, keeps scaling with many producers
+        RELAXED_RING,    // RelaxedMpscQueue, no FIFO order within a partition, near linear producer scaling
+        BROADCAST_RING   // BroadcastQueue, read in full by every consumer of a broadcast group, not a topic setting
+    };
+
+    // Ring of one partition lane, the engine is picked per topic, or BROADCAST_RING for broadcast groups.
+    // All engines live inline in a variant, every call is a switch on an engine that never changes.
+    // Consumer side calls take the reader index, always 0 except on a broadcast ring.
+    class EventRing {
+    public:
+        // Smallest capacity every engine handles: in a one slot ring a published slot also reads as free
+        static constexpr size_t MIN_CAPACITY = RelaxedMpscQueue<Event>::MIN_LANE_CAPACITY;
+
+        EventRing(const QueueEngine engine, const size_t capacity, const size_t reader_count = 1) :
+        engine_(engine), ring_(make_ring(engine, capacity, reader_count)) {}
+
+        bool enqueue(const Event& event) {
+            switch (engine_) {
+                case QueueEngine::FETCH_ADD_RING:
+                    return std::get<FetchAddMpscQueue<Event>>(ring_).enqueue(event);
+                case QueueEngine::RELAXED_RING:
+                    return std::get<RelaxedMpscQueue<Event>>(ring_).enqueue(event);
+                case QueueEngine::BROADCAST_RING:
+                    return std::get<BroadcastQueue<Event>>(ring_).enqueue(event);
+                case QueueEngine::CAS_RING:
+                default:
+                    return std::get<LockFreeMpscQueue<Event>>(ring_).enqueue(event);
+            }
+        }
+
+        size_t enqueue_batch(const Event* events, const size_t count) {
+            switch (engine_) {
+                case QueueEngine::FETCH_ADD_RING:
+                    return std::get<FetchAddMpscQueue<Event>>(ring_).enqueue_batch(events, count);
+                case QueueEngine::RELAXED_RING:
+                    return std::get<RelaxedMpscQueue<Event>>(ring_).enqueue_batch(events, count);
+                case QueueEngine::BROADCAST_RING:
+                    return std::get<BroadcastQueue<Event>>(ring_).enqueue_batch(events, count);
+                case QueueEngine::CAS_RING:
+                default:
+                    return std::get<LockFreeMpscQueue<Event>>(ring_).enqueue_batch(events, count);
+            }
+        }
+
+        bool dequeue(Event& event, const size_t reader = 0) {
+            switch (engine_) {
+                case QueueEngine::FETCH_ADD_RING:
+                    return std::get<FetchAddMpscQueue<Event>>(ring_).dequeue(event);
+                case QueueEngine::RELAXED_RING:
+                    return std::get<RelaxedMpscQueue<Event>>(ring_).dequeue(event);
+                case QueueEngine::BROADCAST_RING:
+                    return std::get<BroadcastQueue<Event>>(ring_).dequeue(reader, event);
+                case QueueEngine::CAS_RING:
+                default:
+                    return std::get<LockFreeMpscQueue<Event>>(ring_).dequeue(event);
+            }
+        }
+
+        size_t dequeue_batch(std::vector<Event>& out, const size_t max_events, const size_t prefetch_distance,
+            const size_t reader = 0) {
+            switch (engine_) {
+                case QueueEngine::FETCH_ADD_RING:
+                    return std::get<FetchAddMpscQueue<Event>>(ring_).dequeue_batch(out, max_events, prefetch_distance);
+                case QueueEngine::RELAXED_RING:
+                    return std::get<RelaxedMpscQueue<Event>>(ring_).dequeue_batch(out, max_events, prefetch_distance);
+                case QueueEngine::BROADCAST_RING:
+                    return std::get<BroadcastQueue<Event>>(ring_).dequeue_batch(reader, out, max_events, prefetch_distance);
+                case QueueEngine::CAS_RING:
+                default:
+                    return std::get<LockFreeMpscQueue<Event>>(ring_).dequeue_batch(out, max_events, prefetch_distance);
+            }
+        }
+
+        // Commit cursors of acknowledged lanes, which always run on BROADCAST_RING, see PartitionLane::acknowledge
+        template<typename Visitor>
+        size_t skip(const size_t reader, const size_t count, Visitor&& visitor) {
+            return std::get<BroadcastQueue<Event>>(ring_).skip(reader, count, visitor);
+        }
+
+        void rewind(const size_t reader, const size_t position) {
+            std::get<BroadcastQueue<Event>>(ring_).rewind(reader, position);
+        }
+
+        template<typename Visitor>
+        void for_each_pending(Visitor&& visitor, const size_t reader = 0) const {
+            std::visit([&](const auto& ring) { for_each_pending_of(ring, visitor, reader); }, ring_);
+        }
+
+        [[nodiscard]] size_t head_position(const size_t reader = 0) const {
+            return std::visit([reader](const auto& ring) { return head_position_of(ring, reader); }, ring_);
+        }
+
+        [[nodiscard]] size_t tail_position() const {
+            return std::visit([](const auto& ring) { return ring.tail_position(); }, ring_);
+        }
+
+        void close() {
+            std::visit([](auto& ring) { ring.close(); }, ring_);
+        }
+
+        [[nodiscard]] bool is_closed() const {
+            return std::visit([](const auto& ring) { return ring.is_closed(); }, ring_);
+        }
+
+        [[nodiscard]] bool is_drained(const size_t reader = 0) const {
+            return std::visit([reader](const auto& ring) { return is_drained_of(ring, reader); }, ring_);
+        }
+
+        [[nodiscard]] size_t size_approx(const size_t reader = 0) const {
+            return std::visit([reader](const auto& ring) { return size_approx_of(ring, reader); }, ring_);
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return std::visit([](const auto& ring) { return ring.capacity(); }, ring_);
+        }
+
+        [[nodiscard]] QueueEngine engine() const {
+            return engine_;
+        }
+
+        static size_t memory_bytes_for_capacity(const QueueEngine engine, const size_t capacity) {
+            switch (engine) {
+                case QueueEngine::FETCH_ADD_RING:
+                    return FetchAddMpscQueue<Event>::memory_bytes_for_capacity(capacity);
+                case QueueEngine::RELAXED_RING:
+                    return RelaxedMpscQueue<Event>::memory_bytes_for_capacity(capacity);
+                case QueueEngine::BROADCAST_RING:
+                    return BroadcastQueue<Event>::memory_bytes_for_capacity(capacity);
+                case QueueEngine::CAS_RING:
+                default:
+                    return LockFreeMpscQueue<Event>::memory_bytes_for_capacity(capacity);
+            }
+        }
+
+    private:
+        using Ring = std::variant<LockFreeMpscQueue<Event>, FetchAddMpscQueue<Event>, RelaxedMpscQueue<Event>,
+            BroadcastQueue<Event>>;
+
+        static Ring make_ring(const QueueEngine engine, const size_t capacity, const size_t reader_count) {
+            switch (engine) {
+                case QueueEngine::FETCH_ADD_RING:
+                    return Ring(std::in_place_type<FetchAddMpscQueue<Event>>, capacity);
+                case QueueEngine::RELAXED_RING:
+                    return Ring(std::in_place_type<RelaxedMpscQueue<Event>>, capacity);
+                case QueueEngine::BROADCAST_RING:
+                    return Ring(std::in_place_type<BroadcastQueue<Event>>, capacity, reader_count);
+                case QueueEngine::CAS_RING:
+                default:
+                    return Ring(std::in_place_type<LockFreeMpscQueue<Event>>, capacity);
+            }
+        }
+
+        // Single consumer rings have one implicit reader
+        template<typename SingleReaderRing, typename Visitor>
+        static void for_each_pending_of(const SingleReaderRing& ring, Visitor& visitor, size_t) {
+            ring.for_each_pending(visitor);
+        }
+
+        template<typename Visitor>
+        static void for_each_pending_of(const BroadcastQueue<Event>& ring, Visitor& visitor, const size_t reader) {
+            ring.for_each_pending(reader, visitor);
+        }
+
+        template<typename SingleReaderRing>
+        static size_t head_position_of(const SingleReaderRing& ring, size_t) {
+            return ring.head_position();
+        }
+
+        static size_t head_position_of(const BroadcastQueue<Event>& ring, const size_t reader) {
+            return ring.head_position(reader);
+        }
+
+        template<typename SingleReaderRing>
+        static bool is_drained_of(const SingleReaderRing& ring, size_t) {
+            return ring.is_drained();
+        }
+
+        static bool is_drained_of(const BroadcastQueue<Event>& ring, const size_t reader) {
+            return ring.is_drained(reader);
+        }
+
+        template<typename SingleReaderRing>
+        static size_t size_approx_of(const SingleReaderRing& ring, size_t) {
+            return ring.size_approx();
+        }
+
+        static size_t size_approx_of(const BroadcastQueue<Event>& ring, const size_t reader) {
+            return ring.size_approx(reader);
+        }
+
+        QueueEngine engine_;
+        Ring ring_;
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+namespace eventbus {
+    struct MemoryUsage {
+        size_t ring_bytes{}; // slot arrays of every partition queue
+        size_t payload_bytes{}; // heap bytes of events sitting in queues, approximate under load
+        size_t budget_bytes{}; // 0 means unlimited
+
+        [[nodiscard]] size_t total_bytes() const {
+            return ring_bytes + payload_bytes;
+        }
+    };
+
+    struct BusMemoryUsage {
+        MemoryUsage total;
+        std::unordered_map<std::string, MemoryUsage> by_topic;
+        std::unordered_map<std::string, MemoryUsage> by_tenant;
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "consumer.hpp"
+#include "event.hpp"
+#include "lock_free_mpsc_queue.hpp"
+
+namespace eventbus {
+    struct ParallelConsumerConfig {
+        size_t worker_count = 4;
+        size_t worker_queue_capacity = 1024; // tasks waiting per worker, power of two
+        size_t max_in_flight_per_partition = 4096; // dispatched but unfinished events per partition, power of two
+    };
+
+    // Key-level parallelism inside partitions. The owning consumer thread calls poll_and_dispatch(), which drains
+    // the consumer's partitions and hands every event to a worker picked by its partition key hash, so events of
+    // one key are handled in order by one worker while different keys of the same hot partition run in parallel.
+    // Keyless events are spread round robin.
+    //
+    // Progress is tracked per assigned partition as a contiguous watermark: completed_position(i) is the number
+    // of events of that partition dispatched since start whose handler, and the handlers of all earlier events of
+    // the partition, have returned. On an acknowledged group (ConsumerGroupConfig::acknowledged) the watermark is
+    // what gets committed: every time it moves, each lane of the partition is acknowledged up to its last event
+    // below it. On other groups events free their slots when dispatched and the watermark is informational.
+    //
+    // A handler that throws does not take its worker down. The event counts as not handled, so the watermark of its
+    // partition stops before it, and the first such exception is rethrown by every later poll_and_dispatch(). In
+    // an acknowledged group its lane is never acknowledged past it: destroy the ParallelConsumer, call
+    // Consumer::redeliver_unacknowledged() and the failed event comes again, along with the events of its lane
+    // handled after it. In any other group the failed event is lost.
+    class ParallelConsumer {
+    public:
+        using Handler = std::function<void(const Event&)>;
+
+        ParallelConsumer(const Consumer& consumer, Handler handler, const ParallelConsumerConfig& config = {});
+
+        ParallelConsumer(const ParallelConsumer&) = delete;
+        ParallelConsumer& operator=(const ParallelConsumer&) = delete;
+
+        // Lets the workers finish what was dispatched, then joins them. An acknowledged group gets everything
+        // handled by then acknowledged.
+        ~ParallelConsumer();
+
+        // Dispatcher side, call from one thread only. Returns how many events were dispatched. Rethrows what a
+        // handler threw, before dispatching anything.
+        size_t poll_and_dispatch(size_t max_events = 256);
+
+        // Dispatcher side as well, advances and returns the watermark of one assigned partition. Acknowledges the
+        // partition's lanes up to it in an acknowledged group.
+        size_t completed_position(size_t assigned_index);
+
+        // True once every dispatched event has been handled
+        [[nodiscard]] bool idle() const;
+
+    private:
+        struct PartitionProgress;
+
+        struct Task {
+            Event event;
+            PartitionProgress* progress{};
+            size_t sequence{}; // per partition dispatch order
+        };
+
+        // Lane and lane position of a dispatched event, acknowledged groups only
+        struct Origin {
+            PartitionLane* lane{};
+            size_t reader{};
+            size_t position{};
+        };
+
+        struct PartitionProgress {
+            PartitionProgress(const size_t window, const bool acknowledged) :
+            done(std::make_unique<std::atomic<bool>[]>(window)),
+            origins(acknowledged ? std::make_unique<Origin[]>(window) : nullptr) {}
+
+            std::unique_ptr<std::atomic<bool>[]> done; // indexed by sequence & (window - 1), set by workers
+            std::unique_ptr<Origin[]> origins; // same index, dispatcher only
+            size_t dispatched{0};
+            size_t completed{0};
+        };
+
+        struct Worker {
+            explicit Worker(const size_t capacity) : tasks(capacity) {}
+
+            LockFreeMpscQueue<Task> tasks; // only the dispatcher produces
+            std::thread thread;
+        };
+
+        void track_assigned_partitions();
+        void run_worker(Worker& worker);
+        size_t pick_worker(const Event& event, size_t sequence) const;
+
+        const Consumer& consumer_;
+        Handler handler_;
+        ParallelConsumerConfig config_;
+        std::vector<std::unique_ptr<PartitionProgress>> progress_; // grows with the assignment, dispatcher only
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<Event> poll_buffer_;
+        std::vector<DeliveredRun> poll_runs_; // of poll_buffer_, acknowledged groups only
+        std::atomic<size_t> in_flight_{0};
+        std::atomic<bool> running_{true};
+        std::atomic<bool> failed_{false};
+        std::mutex failure_mutex_;
+        std::exception_ptr failure_; // first exception a handler threw, guarded by failure_mutex_
+    };
+}
@@ -0,0 +1,833 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "consumer_notifier.hpp"
+#include "event.hpp"
+#include "event_ring.hpp"
+#include "grace_period.hpp"
+
+namespace eventbus {
+    // How a lane allocates its ring. By default the full ring exists from construction on.
+    struct RingAllocation {
+        size_t initial_capacity = 0; // 0 starts at the full capacity, otherwise start here and double when full
+        bool on_first_use = false; // allocate once the first event arrives instead of at construction
+        // Every producer enqueues inside a read guard of this one, which lets retired rings be freed. Null keeps
+        // them until the lane is destroyed.
+        GracePeriod* producer_grace_period = nullptr;
+    };
+
+    // One lane of a partition plus live accounting of the heap payload it holds.
+    // Producers and the consumer keep separate byte counters so accounting never adds a shared read-modify-write
+    // between the two sides.
+    //
+    // The lane owns a chain of rings so its capacity can change while producers are running: migrate() links a
+    // new ring and closes the old one, producers move on as soon as they see the old ring closed, and the consumer
+    // drains the old ring completely before switching, which keeps FIFO order across the migration.
+    // The same chain lets a lane start without a ring or with a small one: the first enqueue allocates it, and a
+    // producer that finds the ring full below the lane's capacity migrates to a ring twice the size.
+    // A retired ring is freed once every ring reader moved past it and the producer grace period elapsed since it
+    // was closed, by whichever reader gets there, without ever waiting on producers.
+    //
+    // A lane of a broadcast group has several readers over BROADCAST_RING rings. Every reader walks the chain on
+    // its own with its own cursor and byte counter, the consumer side calls take the reader index.
+    //
+    // An acknowledged lane keeps dequeued events in their slots until the reader acknowledges them. It always runs
+    // on BROADCAST_RING rings with a second, hidden ring reader per reader: a commit cursor that acknowledge()
+    // moves forward. Producers gate on the slowest ring reader, so nothing after the commit cursor is ever
+    // overwritten, and redeliver() moves the reader back to it. Per lane that is one cursor, not per event state.
+    class PartitionLane {
+    public:
+        PartitionLane(const size_t capacity, const QueueEngine engine, const RingAllocation& allocation = {},
+            const size_t reader_count = 1, const bool acknowledged = false) :
+        engine_(acknowledged ? QueueEngine::BROADCAST_RING : engine),
+        initial_capacity_(allocation.initial_capacity == 0 || allocation.initial_capacity > capacity ? capacity : allocation.initial_capacity),
+        max_capacity_(capacity),
+        reader_count_(reader_count),
+        acknowledged_(acknowledged),
+        producer_grace_period_(allocation.producer_grace_period),
+        readers_(std::make_unique<ReaderState[]>(reader_count)),
+        notifiers_(std::make_unique<std::atomic<ConsumerNotifier*>[]>(reader_count)) {
+            if (!allocation.on_first_use) {
+                std::lock_guard<std::mutex> lock(segments_mutex_);
+                allocate_first_segment();
+            }
+        }
+
+        bool enqueue(const Event& event) {
+            const size_t bytes = payload_bytes_of(event);
+            // Check then act, concurrent producers can overshoot the limit by at most one event each
+            const size_t payload_limit_bytes = payload_limit_bytes_.load(std::memory_order_relaxed);
+            if (payload_limit_bytes != 0 && payload_bytes() + bytes > payload_limit_bytes) {
+                return false;
+            }
+            RingSegment* segment = producer_segment();
+            while (!segment->ring.enqueue(event)) {
+                if (!segment->ring.is_closed() && !grow(segment)) {
+                    return false; // full
+                }
+                // migrated away, next is always linked before the ring gets closed
+                segment = segment->next.load(std::memory_order_acquire);
+            }
+            enqueued_payload_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            notify_readers();
+            return true;
+        }
+
+        // Enqueues a prefix of the batch and returns its length. Stops at the first full ring, the caller decides
+        // what happens to the rest.
+        size_t enqueue_batch(const Event* events, const size_t count) {
+            size_t bytes = 0;
+            for (size_t i = 0; i < count; ++i) {
+                bytes += payload_bytes_of(events[i]);
+            }
+            const size_t payload_limit_bytes = payload_limit_bytes_.load(std::memory_order_relaxed);
+            if (payload_limit_bytes != 0 && payload_bytes() + bytes > payload_limit_bytes) {
+                return 0; // let the caller go event by event against the limit
+            }
+            size_t enqueued = 0;
+            RingSegment* segment = producer_segment();
+            while (enqueued < count) {
+                const size_t batch = segment->ring.enqueue_batch(events + enqueued, count - enqueued);
+                enqueued += batch;
+                if (enqueued < count && batch == 0) {
+                    if (!segment->ring.is_closed() && !grow(segment)) {
+                        break; // full
+                    }
+                    segment = segment->next.load(std::memory_order_acquire);
+                }
+            }
+            if (enqueued < count) {
+                for (size_t i = enqueued; i < count; ++i) {
+                    bytes -= payload_bytes_of(events[i]);
+                }
+            }
+            enqueued_payload_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            if (enqueued != 0) {
+                notify_readers();
+            }
+            return enqueued;
+        }
+
+        bool dequeue(Event& event, const size_t reader = 0) {
+            ReaderState& state = readers_[reader];
+            if (state.segment == nullptr && !attach_reader(state)) {
+                return false;
+            }
+            if (reclaim_pending_.load(std::memory_order_relaxed)) {
+                reclaim_segments();
+            }
+            while (!state.segment->ring.dequeue(event, reader)) {
+                if (!state.segment->ring.is_drained(reader)) {
+                    return false;
+                }
+                advance_reader(state, reader);
+            }
+            if (!acknowledged_) {
+                // single thread per reader, plain load + store is enough
+                state.dequeued_payload_bytes.store(state.dequeued_payload_bytes.load(std::memory_order_relaxed) +
+                    payload_bytes_of(event), std::memory_order_relaxed);
+                publish_consumed_position(state, reader, head_position(reader));
+            }
+            return true;
+        }
+
+        // Appends up to max_events to out, crossing into the next ring of a migration like dequeue() does
+        size_t dequeue_batch(std::vector<Event>& out, const size_t max_events, const size_t prefetch_distance,
+            const size_t reader = 0) {
+            ReaderState& state = readers_[reader];
+            if (state.segment == nullptr && !attach_reader(state)) {
+                return 0;
+            }
+            if (reclaim_pending_.load(std::memory_order_relaxed)) {
+                reclaim_segments();
+            }
+            const size_t first = out.size();
+            size_t taken = 0;
+            while (taken < max_events) {
+                taken += state.segment->ring.dequeue_batch(out, max_events - taken, prefetch_distance, reader);
+                if (taken == max_events || !state.segment->ring.is_drained(reader)) {
+                    break;
+                }
+                advance_reader(state, reader);
+            }
+            if (taken != 0 && !acknowledged_) {
+                size_t bytes = 0;
+                for (size_t i = first; i < out.size(); ++i) {
+                    bytes += payload_bytes_of(out[i]);
+                }
+                state.dequeued_payload_bytes.store(state.dequeued_payload_bytes.load(std::memory_order_relaxed) + bytes,
+                    std::memory_order_relaxed);
+                publish_consumed_position(state, reader, head_position(reader));
+            }
+            return taken;
+        }
+
+        // Acknowledged lanes: releases the slots of one reader up to position, cumulatively like committing an
+        // offset. Capped at what the reader dequeued, positions it already acknowledged change nothing. Payload
+        // bytes count as consumed from here on rather than from the dequeue. Same thread as the reader's dequeues.
+        void acknowledge(size_t position, const size_t reader = 0) {
+            ReaderState& state = readers_[reader];
+            position = std::min(position, head_position(reader));
+            if (position <= state.consumed_position.load(std::memory_order_relaxed)) {
+                return;
+            }
+            if (state.commit_segment == nullptr) {
+                state.commit_segment = first_segment_.load(std::memory_order_acquire); // allocated, events were dequeued
+            }
+            const size_t commit_reader = reader + reader_count_;
+            size_t bytes = 0;
+            const auto count_bytes = [&bytes](const Event& event) { bytes += payload_bytes_of(event); };
+            while (true) {
+                EventRing& ring = state.commit_segment->ring;
+                const size_t head = ring.head_position(commit_reader);
+                const size_t target = position - state.commit_base_position;
+                if (!ring.is_closed() || target <= ring.tail_position()) {
+                    ring.skip(commit_reader, target - head, count_bytes); // all dequeued, so all published
+                    break;
+                }
+                // Past a ring a migration retired, the reader got through it already
+                ring.skip(commit_reader, ring.tail_position() - head, count_bytes);
+                state.commit_base_position += ring.tail_position();
+                RingSegment* passed = state.commit_segment;
+                state.commit_segment = passed->next.load(std::memory_order_acquire);
+                depart(passed);
+            }
+            state.dequeued_payload_bytes.store(state.dequeued_payload_bytes.load(std::memory_order_relaxed) + bytes,
+                std::memory_order_relaxed);
+            publish_consumed_position(state, reader, position);
+        }
+
+        // Acknowledged lanes: moves one reader back to its commit cursor, it dequeues every event it had not
+        // acknowledged again. On the reader's thread, or with that thread gone.
+        void redeliver(const size_t reader = 0) {
+            ReaderState& state = readers_[reader];
+            if (state.segment == nullptr) {
+                return; // never dequeued anything
+            }
+            const size_t commit_reader = reader + reader_count_;
+            RingSegment* commit_segment = first_commit_segment(reader);
+            for (RingSegment* segment = commit_segment; ; segment = segment->next.load(std::memory_order_acquire)) {
+                segment->ring.rewind(reader, segment->ring.head_position(commit_reader));
+                if (segment == state.segment) {
+                    break;
+                }
+                // The reader had left it, the commit reader never did, so it is still allocated
+                segment->departed_readers.fetch_sub(1, std::memory_order_relaxed);
+            }
+            state.segment = commit_segment;
+            state.base_position = state.commit_base_position;
+        }
+
+        [[nodiscard]] bool is_acknowledged() const {
+            return acknowledged_;
+        }
+
+        // Control plane: changes the lane capacity. A lane that allocates its full capacity up front moves to a
+        // ring of the new size right away, a growing lane only when its current ring is larger than allowed now.
+        void resize(const size_t capacity) {
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            const bool grows = initial_capacity_ < max_capacity_.load(std::memory_order_relaxed);
+            initial_capacity_ = grows && initial_capacity_ < capacity ? initial_capacity_ : capacity;
+            max_capacity_.store(capacity, std::memory_order_relaxed);
+            const RingSegment* segment = producer_segment_.load(std::memory_order_acquire);
+            if (segment != nullptr && (grows ? segment->ring.capacity() > capacity : segment->ring.capacity() != capacity)) {
+                migrate(capacity);
+            }
+        }
+
+        // Producer side estimate of what the slowest reader still has to read from the ring producers fill now,
+        // from the ring's head and tail only. Rings a migration retired are not counted. Producers only, inside
+        // their producer grace period guard like enqueue().
+        [[nodiscard]] size_t depth_approx() const {
+            assert(is_producer_guarded());
+            const RingSegment* segment = producer_segment_.load(std::memory_order_seq_cst);
+            if (segment == nullptr) {
+                return 0;
+            }
+            size_t depth = 0;
+            for (size_t reader = 0; reader < ring_reader_count(); ++reader) { // unacknowledged events hold slots too
+                depth = std::max(depth, segment->ring.size_approx(reader));
+            }
+            return depth;
+        }
+
+        // Capacity of the ring producers currently fill, 0 while nothing is allocated
+        [[nodiscard]] size_t capacity() const {
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            const RingSegment* segment = producer_segment_.load(std::memory_order_acquire);
+            return segment != nullptr ? segment->ring.capacity() : 0;
+        }
+
+        // Events waiting in every ring still to be drained, consumer side estimate
+        [[nodiscard]] size_t size_approx(const size_t reader = 0) const {
+            size_t size = 0;
+            for (const RingSegment* segment = first_reader_segment(reader); segment != nullptr;
+                 segment = segment->next.load(std::memory_order_acquire)) {
+                size += segment->ring.size_approx(reader);
+            }
+            return size;
+        }
+
+        // Visits pending events of every ring still to be drained, oldest first. Producers and consumer must be quiesced.
+        // An acknowledged lane counts everything after the commit cursor as pending, dequeued or not.
+        template<typename Visitor>
+        void for_each_pending(Visitor&& visitor, const size_t reader = 0) const {
+            const size_t ring_reader = acknowledged_ ? reader + reader_count_ : reader;
+            for (const RingSegment* segment = acknowledged_ ? first_commit_segment(reader) : first_reader_segment(reader);
+                 segment != nullptr; segment = segment->next.load(std::memory_order_acquire)) {
+                segment->ring.for_each_pending(visitor, ring_reader);
+            }
+        }
+
+        // Consumer cursor, i.e. how many events were ever dequeued from this lane
+        [[nodiscard]] size_t head_position(const size_t reader = 0) const {
+            const RingSegment* segment = first_reader_segment(reader);
+            return readers_[reader].base_position + (segment != nullptr ? segment->ring.head_position(reader) : 0);
+        }
+
+        // Same cursor, published by the consumer after every dequeue so other threads can read it. In an
+        // acknowledged lane the commit cursor instead, published by acknowledge().
+        [[nodiscard]] size_t consumed_position(const size_t reader = 0) const {
+            return readers_[reader].consumed_position.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] size_t reader_count() const {
+            return reader_count_;
+        }
+
+        // Producers signal the notifier of a reader after every enqueue, see ConsumerNotifier. Null detaches.
+        void set_notifier(const size_t reader, ConsumerNotifier* notifier) {
+            notifiers_[reader].store(notifier, std::memory_order_release);
+        }
+
+        // Signals whatever notifier sits in the slot once reader has consumed up to position, right away if it
+        // already has. Wakes the consumer of a partition fenced on this lane, see PartitionQueue::set_fence_cuts.
+        // The slot must outlive the lane's readers.
+        void watch_consumed_position(const size_t reader, const size_t position,
+            const std::atomic<ConsumerNotifier*>* notifier) {
+            {
+                std::lock_guard<std::mutex> lock(watches_mutex_);
+                watches_.push_back({reader, position, notifier});
+            }
+            has_watches_.store(true, std::memory_order_seq_cst);
+            notify_watches(reader);
+        }
+
+        // Reader furthest behind, whose pending events cover every other reader's. Consumers must be quiesced.
+        [[nodiscard]] size_t slowest_reader() const {
+            size_t slowest = 0;
+            for (size_t reader = 1; reader < reader_count_; ++reader) {
+                if (consumed_position(reader) < consumed_position(slowest)) {
+                    slowest = reader;
+                }
+            }
+            return slowest;
+        }
+
+        // Lane position behind every slot claimed so far, control plane only like migrate().
+        // Once the consumer cursor reaches it, everything enqueued before this call has been consumed.
+        [[nodiscard]] size_t enqueue_position() const {
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            const RingSegment* segment = producer_segment_.load(std::memory_order_acquire);
+            return producer_base_ + (segment != nullptr ? segment->ring.tail_position() : 0);
+        }
+
+        // Carries a cursor over from a snapshot, only on a fresh lane before any event went through it
+        void reset_position(const size_t position) {
+            producer_base_ = position;
+            for (size_t reader = 0; reader < reader_count_; ++reader) {
+                readers_[reader].base_position = position;
+                readers_[reader].commit_base_position = position;
+                readers_[reader].consumed_position.store(position, std::memory_order_release);
+            }
+        }
+
+        // Allocated now, including retired rings not freed yet
+        [[nodiscard]] size_t ring_bytes() const {
+            return ring_bytes_.load(std::memory_order_relaxed);
+        }
+
+        // What the rings may take without any reconfiguration: everything allocated now plus every ring still to
+        // come while growing to the full capacity. Budgets are checked against this so growing never breaks one.
+        [[nodiscard]] size_t reserved_ring_bytes() const {
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            const RingSegment* segment = producer_segment_.load(std::memory_order_acquire);
+            const size_t max_capacity = max_capacity_.load(std::memory_order_relaxed);
+            if (segment == nullptr) {
+                return ring_bytes() + reserved_ring_bytes_for(engine_, max_capacity, initial_capacity_);
+            }
+            return ring_bytes() + reserved_ring_bytes_for(engine_, max_capacity, segment->ring.capacity()) -
+                segment->ring_bytes();
+        }
+
+        // Rings a lane allocates going from its first ring of initial_capacity to capacity by doubling
+        static size_t reserved_ring_bytes_for(const QueueEngine engine, const size_t capacity, size_t initial_capacity) {
+            if (initial_capacity == 0 || initial_capacity > capacity) {
+                initial_capacity = capacity;
+            }
+            size_t bytes = EventRing::memory_bytes_for_capacity(engine, initial_capacity);
+            for (size_t ring_capacity = initial_capacity; ring_capacity < capacity; ) {
+                ring_capacity = std::min(ring_capacity * 2, capacity);
+                bytes += EventRing::memory_bytes_for_capacity(engine, ring_capacity);
+            }
+            return bytes;
+        }
+
+        // Heap bytes owned by events currently sitting in the rings, approximate while producers are active.
+        // An event stays in a broadcast ring until its slowest reader is past it.
+        [[nodiscard]] size_t payload_bytes() const {
+            size_t dequeued = readers_[0].dequeued_payload_bytes.load(std::memory_order_relaxed);
+            for (size_t reader = 1; reader < reader_count_; ++reader) {
+                dequeued = std::min(dequeued, readers_[reader].dequeued_payload_bytes.load(std::memory_order_relaxed));
+            }
+            const size_t enqueued = enqueued_payload_bytes_.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        // 0 means unlimited
+        void set_payload_limit_bytes(const size_t limit) {
+            payload_limit_bytes_.store(limit, std::memory_order_relaxed);
+        }
+
+        static size_t payload_bytes_of(const Event& event) {
+            return event.topic.size() + event.payload.size();
+        }
+
+    private:
+        struct RingSegment;
+
+        // Sequentially consistent with the store in migrate() and the producer grace period epoch, so a producer
+        // that entered its guard after a ring was retired never loads that ring
+        RingSegment* producer_segment() {
+            assert(is_producer_guarded());
+            RingSegment* segment = producer_segment_.load(std::memory_order_seq_cst);
+            if (segment != nullptr) {
+                return segment;
+            }
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            return allocate_first_segment();
+        }
+
+#ifndef NDEBUG
+        // Lock free readers of producer_segment_ may only dereference it inside the producer guard, the ring can
+        // be freed under them otherwise
+        [[nodiscard]] bool is_producer_guarded() const {
+            return producer_grace_period_ == nullptr || producer_grace_period_->is_held_by_this_thread();
+        }
+#endif
+
+        // With segments_mutex_ held, idempotent
+        RingSegment* allocate_first_segment() {
+            RingSegment* segment = producer_segment_.load(std::memory_order_relaxed);
+            if (segment != nullptr) {
+                return segment;
+            }
+            auto first = std::make_unique<RingSegment>(engine_, initial_capacity_, ring_reader_count());
+            segment = first.get();
+            ring_bytes_.fetch_add(segment->ring_bytes(), std::memory_order_relaxed);
+            segments_.push_back(std::move(first));
+            first_segment_.store(segment, std::memory_order_release);
+            producer_segment_.store(segment, std::memory_order_release);
+            return segment;
+        }
+
+        // Producer side, full_segment was found full. True when there is a newer ring to retry on.
+        bool grow(const RingSegment* full_segment) {
+            if (full_segment->ring.capacity() >= max_capacity_.load(std::memory_order_relaxed)) {
+                return false; // checked without the lock, a lane at full size stays lock free when full
+            }
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            if (producer_segment_.load(std::memory_order_relaxed) != full_segment) {
+                return true; // another producer grew it first
+            }
+            const size_t max_capacity = max_capacity_.load(std::memory_order_relaxed);
+            if (full_segment->ring.capacity() >= max_capacity) {
+                return false;
+            }
+            migrate(std::min(full_segment->ring.capacity() * 2, max_capacity));
+            return true;
+        }
+
+        // With segments_mutex_ held. The old ring stays allocated until its readers are through and no producer
+        // may still be looking at it, see reclaim_segments().
+        void migrate(const size_t new_capacity) {
+            RingSegment* old_segment = producer_segment_.load(std::memory_order_acquire);
+            auto segment = std::make_unique<RingSegment>(engine_, new_capacity, ring_reader_count());
+            old_segment->next.store(segment.get(), std::memory_order_release);
+            producer_segment_.store(segment.get(), std::memory_order_seq_cst);
+            old_segment->ring.close();
+            producer_base_ += old_segment->ring.tail_position(); // final once closed
+            // Taken after the new ring is published: producers that enter later never load the old one
+            if (producer_grace_period_ != nullptr) {
+                old_segment->retired_epoch = producer_grace_period_->current_epoch();
+            }
+            ring_bytes_.fetch_add(segment->ring_bytes(), std::memory_order_relaxed);
+            segments_.push_back(std::move(segment));
+        }
+
+        // Reader side, a ring reader moved on from segment for good
+        void depart(RingSegment* segment) {
+            if (segment->departed_readers.fetch_add(1, std::memory_order_acq_rel) + 1 == ring_reader_count() &&
+                producer_grace_period_ != nullptr) {
+                reclaim_pending_.store(true, std::memory_order_relaxed);
+                reclaim_segments();
+            }
+        }
+
+        // Frees retired rings from the front of the chain that every ring reader left, once no producer can be
+        // inside them anymore. Readers are past them and only look at later rings, so no reader can either.
+        // Retried on the readers' next dequeues while producers are still in the grace period.
+        void reclaim_segments() {
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            while (segments_.size() > 1) {
+                RingSegment* oldest = segments_.front().get();
+                if (oldest->departed_readers.load(std::memory_order_acquire) != ring_reader_count()) {
+                    reclaim_pending_.store(false, std::memory_order_relaxed); // a later depart() sets it again
+                    return;
+                }
+                if (!producer_grace_period_->try_elapse(oldest->retired_epoch)) {
+                    reclaim_pending_.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                first_segment_.store(oldest->next.load(std::memory_order_acquire), std::memory_order_release);
+                ring_bytes_.fetch_sub(oldest->ring_bytes(), std::memory_order_relaxed);
+                segments_.erase(segments_.begin());
+            }
+            reclaim_pending_.store(false, std::memory_order_relaxed);
+        }
+
+        // Consumer side of one reader, owned by the thread reading through it
+        struct alignas(64) ReaderState {
+            RingSegment* segment{nullptr}; // null until the reader saw the first ring
+            size_t base_position{0}; // lane position of the first slot of segment, set by reset_position()
+            RingSegment* commit_segment{nullptr}; // acknowledged lanes, where the commit cursor is, null for the first ring
+            size_t commit_base_position{0};
+            std::atomic<size_t> dequeued_payload_bytes{0};
+            std::atomic<size_t> consumed_position{0}; // written next to the byte counter
+        };
+
+        // Readers of every ring, the commit cursors of an acknowledged lane follow the readers
+        [[nodiscard]] size_t ring_reader_count() const {
+            return acknowledged_ ? reader_count_ * 2 : reader_count_;
+        }
+
+        void notify_readers() const {
+            for (size_t reader = 0; reader < reader_count_; ++reader) {
+                ConsumerNotifier* notifier = notifiers_[reader].load(std::memory_order_acquire);
+                if (notifier != nullptr) {
+                    notifier->notify();
+                }
+            }
+        }
+
+        // Reader side of a lane whose ring is allocated on first use
+        bool attach_reader(ReaderState& state) {
+            state.segment = first_segment_.load(std::memory_order_acquire);
+            return state.segment != nullptr;
+        }
+
+        // Reader side. Sequentially consistent with has_watches_, so either a new watch sees the position or the
+        // reader sees the watch.
+        void publish_consumed_position(ReaderState& state, const size_t reader, const size_t position) {
+            state.consumed_position.store(position, std::memory_order_seq_cst);
+            if (has_watches_.load(std::memory_order_seq_cst)) {
+                notify_watches(reader);
+            }
+        }
+
+        void notify_watches(const size_t reader) {
+            std::lock_guard<std::mutex> lock(watches_mutex_);
+            const size_t position = consumed_position(reader);
+            const auto passed = [reader, position](const ConsumedWatch& watch) {
+                return watch.reader == reader && watch.position <= position;
+            };
+            for (const ConsumedWatch& watch : watches_) {
+                ConsumerNotifier* notifier = passed(watch) ? watch.notifier->load(std::memory_order_acquire) : nullptr;
+                if (notifier != nullptr) {
+                    notifier->notify();
+                }
+            }
+            watches_.erase(std::remove_if(watches_.begin(), watches_.end(), passed), watches_.end());
+            if (watches_.empty()) {
+                has_watches_.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // The reader drained a closed ring, next is always linked before a ring gets closed
+        void advance_reader(ReaderState& state, const size_t reader) {
+            RingSegment* drained = state.segment;
+            state.base_position += drained->ring.head_position(reader);
+            state.segment = drained->next.load(std::memory_order_acquire);
+            depart(drained);
+        }
+
+        [[nodiscard]] const RingSegment* first_reader_segment(const size_t reader) const {
+            const RingSegment* segment = readers_[reader].segment;
+            return segment != nullptr ? segment : first_segment_.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] RingSegment* first_commit_segment(const size_t reader) const {
+            RingSegment* segment = readers_[reader].commit_segment;
+            return segment != nullptr ? segment : first_segment_.load(std::memory_order_acquire);
+        }
+
+        struct ConsumedWatch {
+            size_t reader;
+            size_t position;
+            const std::atomic<ConsumerNotifier*>* notifier;
+        };
+
+        struct RingSegment {
+            RingSegment(const QueueEngine engine, const size_t capacity, const size_t reader_count) :
+            ring(engine, capacity, reader_count) {}
+
+            [[nodiscard]] size_t ring_bytes() const {
+                return EventRing::memory_bytes_for_capacity(ring.engine(), ring.capacity());
+            }
+
+            EventRing ring;
+            std::atomic<RingSegment*> next{nullptr};
+            std::atomic<size_t> departed_readers{0}; // ring readers that moved on to next
+            size_t retired_epoch{0}; // producer grace period epoch once closed, guarded by segments_mutex_
+        };
+
+        QueueEngine engine_;
+        size_t initial_capacity_; // of the first ring, guarded by segments_mutex_
+        std::atomic<size_t> max_capacity_; // rings grow up to this, written under segments_mutex_
+        mutable std::mutex segments_mutex_; // allocation, growth and migrations
+        std::vector<std::unique_ptr<RingSegment>> segments_; // owns every ring, oldest first, guarded by segments_mutex_
+        std::atomic<RingSegment*> first_segment_{nullptr};
+        std::atomic<RingSegment*> producer_segment_{nullptr};
+        size_t producer_base_{0}; // lane position of the producer ring's first slot, guarded by segments_mutex_
+        size_t reader_count_;
+        bool acknowledged_;
+        GracePeriod* producer_grace_period_; // null keeps retired rings
+        std::atomic<bool> reclaim_pending_{false}; // a retired ring is left by all readers but not freed yet
+        std::unique_ptr<ReaderState[]> readers_; // one per reader, 1 unless the lane belongs to a broadcast group
+        std::unique_ptr<std::atomic<ConsumerNotifier*>[]> notifiers_; // per reader, read by producers, mostly null
+        std::mutex watches_mutex_;
+        std::vector<ConsumedWatch> watches_; // guarded by watches_mutex_, empty unless a repartition is under way
+        std::atomic<bool> has_watches_{false};
+        std::atomic<size_t> payload_limit_bytes_{0};
+        std::atomic<size_t> ring_bytes_{0};
+        alignas(64) std::atomic<size_t> enqueued_payload_bytes_{0};
+    };
+
+    // Position a lane has to be consumed up to before a fenced partition opens
+    struct FenceCut {
+        PartitionLane* lane;
+        size_t position;
+    };
+
+    // Where a run of consecutive events in a polled batch came from, lets a consumer acknowledge single events
+    struct DeliveredRun {
+        PartitionLane* lane;
+        size_t reader;
+        size_t first_index; // in the batch
+        size_t first_position; // lane position of the event at first_index
+    };
+
+    // One partition of one consumer group. Lane 0 is shared by untagged publishers, tenants configured with
+    // isolated queues get a lane of their own so their bursts can only fill their own ring.
+    // FIFO order holds per lane; the consumer rotates over lanes so none of them can starve the others.
+    //
+    // A partition added by a repartition starts fenced: keys that moved into it may still have older events in
+    // the partitions they came from. Producers can fill it right away, but the consumer gets nothing out of it
+    // until the cuts are set and every cut lane has been consumed up to its cut.
+    //
+    // In a broadcast group every consumer reads the same lanes: this queue is reader 0, reader_view() hands out
+    // the others. Views share the lanes but keep their own lane rotation and fence.
+    class PartitionQueue {
+    public:
+        explicit PartitionQueue(const size_t capacity, const QueueEngine engine = QueueEngine::CAS_RING,
+            const RingAllocation& allocation = {}, const bool fenced = false, const size_t reader_count = 1,
+            const bool acknowledged = false) :
+        engine_(engine),
+        tenant_lane_allocation_{0, allocation.on_first_use, allocation.producer_grace_period},
+        reader_count_(reader_count),
+        acknowledged_(acknowledged),
+        fence_state_(fenced ? FENCE_AWAITING_CUTS : FENCE_OPEN) {
+            lanes_.push_back(std::make_shared<PartitionLane>(capacity, engine_, allocation, reader_count_, acknowledged_));
+        }
+
+        // Only while the bus is being built and before any reader view exists. Tenant lanes start at their full
+        // capacity but share lazy allocation and the producer grace period.
+        size_t add_lane(const size_t capacity) {
+            lanes_.push_back(std::make_shared<PartitionLane>(capacity, engine_, tenant_lane_allocation_, reader_count_,
+                acknowledged_));
+            return lanes_.size() - 1;
+        }
+
+        // The same partition seen by another reader of a broadcast group, fenced if this queue still is
+        [[nodiscard]] std::shared_ptr<PartitionQueue> reader_view(const size_t reader_index) const {
+            return std::shared_ptr<PartitionQueue>(new PartitionQueue(*this, reader_index));
+        }
+
+        bool enqueue(const Event& event) {
+            return lanes_[0]->enqueue(event);
+        }
+
+        bool dequeue(Event& event) {
+            if (fence_state_.load(std::memory_order_acquire) != FENCE_OPEN && !try_open_fence()) {
+                return false;
+            }
+            const size_t lane_count = lanes_.size();
+            if (lane_count == 1) {
+                return lanes_[0]->dequeue(event, reader_index_);
+            }
+            for (size_t i = 0; i < lane_count; ++i) {
+                const size_t lane_index = next_lane_;
+                next_lane_ = next_lane_ + 1 == lane_count ? 0 : next_lane_ + 1;
+                if (lanes_[lane_index]->dequeue(event, reader_index_)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Batch form of dequeue(), starts one lane further on every call. With runs, appends where the events came
+        // from, one entry per lane that had any.
+        size_t dequeue_batch(std::vector<Event>& out, const size_t max_events, const size_t prefetch_distance,
+            std::vector<DeliveredRun>* runs = nullptr) {
+            if (fence_state_.load(std::memory_order_acquire) != FENCE_OPEN && !try_open_fence()) {
+                return 0;
+            }
+            const size_t lane_count = lanes_.size();
+            if (lane_count == 1 && runs == nullptr) {
+                return lanes_[0]->dequeue_batch(out, max_events, prefetch_distance, reader_index_);
+            }
+            size_t taken = 0;
+            for (size_t i = 0; i < lane_count && taken < max_events; ++i) {
+                const size_t lane_index = next_lane_ + i < lane_count ? next_lane_ + i : next_lane_ + i - lane_count;
+                PartitionLane* lane = lanes_[lane_index].get();
+                const size_t first_index = out.size();
+                const size_t lane_taken = lane->dequeue_batch(out, max_events - taken, prefetch_distance, reader_index_);
+                if (runs != nullptr && lane_taken != 0) {
+                    runs->push_back({lane, reader_index_, first_index, lane->head_position(reader_index_) - lane_taken});
+                }
+                taken += lane_taken;
+            }
+            next_lane_ = next_lane_ + 1 == lane_count ? 0 : next_lane_ + 1;
+            return taken;
+        }
+
+        // Acknowledged groups: releases every event this reader dequeued from the partition so far
+        void acknowledge() const {
+            for (const auto& lane : lanes_) {
+                lane->acknowledge(lane->head_position(reader_index_), reader_index_);
+            }
+        }
+
+        // Acknowledged groups: hands every event this reader has not acknowledged out again, see PartitionLane::redeliver
+        void redeliver() const {
+            for (const auto& lane : lanes_) {
+                lane->redeliver(reader_index_);
+            }
+        }
+
+        // Control plane, once per fenced partition. The lanes must outlive this queue's fence. Each cut lane
+        // signals this queue's notifier once consumed up to its cut, so an armed consumer wakes up to open the fence.
+        void set_fence_cuts(std::vector<FenceCut> cuts) {
+            fence_cuts_ = std::move(cuts);
+            fence_state_.store(FENCE_CUTS_SET, std::memory_order_release);
+            for (const FenceCut& cut : fence_cuts_) {
+                cut.lane->watch_consumed_position(reader_index_, cut.position, &notifier_);
+            }
+        }
+
+        // Consumer only. False while a repartition fence holds the partition back, opens the fence when it can.
+        bool is_open() {
+            return fence_state_.load(std::memory_order_acquire) == FENCE_OPEN || try_open_fence();
+        }
+
+        [[nodiscard]] PartitionLane* lane(const size_t lane_index) const {
+            return lanes_[lane_index].get();
+        }
+
+        [[nodiscard]] size_t lane_count() const {
+            return lanes_.size();
+        }
+
+        // Signals notifier whenever a producer enqueues into any lane of this partition
+        void set_notifier(ConsumerNotifier* notifier) {
+            notifier_.store(notifier, std::memory_order_release);
+            for (const auto& lane : lanes_) {
+                lane->set_notifier(reader_index_, notifier);
+            }
+        }
+
+        // Reader this queue consumes as, 0 outside broadcast groups
+        [[nodiscard]] size_t reader_index() const {
+            return reader_index_;
+        }
+
+        [[nodiscard]] size_t size_approx() const {
+            size_t size = 0;
+            for (const auto& lane : lanes_) {
+                size += lane->size_approx(reader_index_);
+            }
+            return size;
+        }
+
+        [[nodiscard]] size_t ring_bytes() const {
+            size_t bytes = 0;
+            for (const auto& lane : lanes_) {
+                bytes += lane->ring_bytes();
+            }
+            return bytes;
+        }
+
+        [[nodiscard]] size_t payload_bytes() const {
+            size_t bytes = 0;
+            for (const auto& lane : lanes_) {
+                bytes += lane->payload_bytes();
+            }
+            return bytes;
+        }
+
+    private:
+        static constexpr int FENCE_OPEN = 0;
+        static constexpr int FENCE_AWAITING_CUTS = 1;
+        static constexpr int FENCE_CUTS_SET = 2;
+
+        PartitionQueue(const PartitionQueue& reader_0, const size_t reader_index) :
+        engine_(reader_0.engine_),
+        tenant_lane_allocation_(reader_0.tenant_lane_allocation_),
+        reader_count_(reader_0.reader_count_),
+        acknowledged_(reader_0.acknowledged_),
+        reader_index_(reader_index),
+        lanes_(reader_0.lanes_),
+        fence_state_(reader_0.fence_state_.load(std::memory_order_acquire) == FENCE_OPEN ? FENCE_OPEN : FENCE_AWAITING_CUTS) {}
+
+        // Consumer only, the control plane is done with fence_cuts_ once the state says they are set
+        bool try_open_fence() {
+            if (fence_state_.load(std::memory_order_acquire) == FENCE_AWAITING_CUTS) {
+                return false;
+            }
+            for (const FenceCut& cut : fence_cuts_) {
+                if (cut.lane->consumed_position(reader_index_) < cut.position) {
+                    return false;
+                }
+            }
+            fence_cuts_.clear();
+            fence_state_.store(FENCE_OPEN, std::memory_order_relaxed);
+            return true;
+        }
+
+        QueueEngine engine_;
+        RingAllocation tenant_lane_allocation_;
+        size_t reader_count_;
+        bool acknowledged_;
+        size_t reader_index_{0};
+        std::vector<std::shared_ptr<PartitionLane>> lanes_; // shared with the reader views of a broadcast group
+        size_t next_lane_{0}; // consumer only
+        std::atomic<int> fence_state_;
+        std::vector<FenceCut> fence_cuts_;
+        std::atomic<ConsumerNotifier*> notifier_{nullptr}; // of the consumer reading this queue, woken by fence cuts
+    };
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "event.hpp"
+#include "tenant.hpp"
+
+namespace eventbus {
+    class EventBus;
+    class Topic;
+
+    struct PublisherConfig {
+        size_t max_batch_events = 64; // a partition buffer is flushed as soon as it holds this many events
+        std::chrono::nanoseconds max_batch_delay = std::chrono::microseconds(5); // oldest buffered event may wait this long
+    };
+
+    // Per-thread publishing front end that coalesces single publish() calls into one batched enqueue per partition.
+    // Message ids and partitions are assigned at publish() time exactly like EventBus::publish_event, so ordering
+    // per partition key is unchanged; only the ring claim is shared by the whole batch. Buffers of a topic that
+    // was repartitioned in the meantime are re-sorted by the new routing before they are handed over.
+    // On a total order topic the sequences are taken at flush time, one reservation for the whole flush, so the
+    // sequence order is the order flushes reach the rings rather than the order of the publish() calls.
+    //
+    // There is no background timer: the delay budget is checked on every publish(), so a thread that goes idle
+    // should call flush(). The destructor flushes as well. Not thread safe, use one Publisher per producer thread,
+    // and never let it outlive its EventBus.
+    class Publisher {
+    public:
+        explicit Publisher(EventBus& event_bus, const PublisherConfig& config = {});
+
+        // Publishes on behalf of a tenant, see EventBus::publish_event(TenantTag, ...)
+        Publisher(EventBus& event_bus, TenantTag tenant_tag, const PublisherConfig& config = {});
+
+        Publisher(const Publisher&) = delete;
+        Publisher& operator=(const Publisher&) = delete;
+
+        ~Publisher();
+
+        // Buffers the event. Returns false when the topic has no consumer groups, the tenant is over quota, or a
+        // flush triggered by this call could not deliver everything.
+        bool publish(Event event, const std::string& partition_key = "");
+
+        // Hands every buffered event to the bus, returns false if any of them was dropped by back-pressure
+        bool flush();
+
+        [[nodiscard]] size_t buffered_events() const {
+            return buffered_events_;
+        }
+
+    private:
+        using PartitionBuffers = std::vector<std::vector<Event>>;
+
+        struct TopicBuffers {
+            Topic* topic; // resolved once, topics live as long as the bus
+            PartitionBuffers partitions; // one buffer per partition
+        };
+
+        static constexpr size_t ALL_PARTITIONS = SIZE_MAX;
+
+        bool flush_buffers(TopicBuffers& topic_buffers, size_t partition_index);
+        static void stamp_sequences(Topic& topic, PartitionBuffers& partition_buffers, size_t first, size_t last);
+        static void rebucket(PartitionBuffers& partition_buffers, size_t partition_count);
+
+        EventBus& event_bus_;
+        PublisherConfig config_;
+        size_t tenant_index_;
+        size_t lane_index_;
+        std::unordered_map<std::string, TopicBuffers> buffers_by_topic_;
+        size_t buffered_events_{0};
+        std::chrono::steady_clock::time_point oldest_buffered_at_; // valid while buffered_events_ != 0
+    };
+}
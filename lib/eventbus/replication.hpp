@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "event_bus.hpp"
+
+namespace eventbus {
+    // Hot standby over a loopback TCP connection. Every topic configured with TopicConfig::replicated fans out to
+    // one more consumer group, and a ReplicationSender thread on the primary drains that group lane by lane.
+    // It ships the events plus the cursors of every other group of the topic, batched into one send per round.
+    // Publishers only pay the extra enqueue into that group's rings. A StandbyReplica in the second process
+    // keeps what is still unconsumed by some group, and take_over() loads it into the standby's own bus, which
+    // starts consuming where the primary's groups were.
+    //
+    // Lane positions are what ties the streams together: the n-th event of a lane is the same in every group of a
+    // topic. A replicated topic makes sure of it. The bus refuses any back-pressure but BLOCK, so no group drops an
+    // event the others got, and producers fan out into a partition lane one at a time, so concurrent producers
+    // cannot reach two groups in a different order. A takeover therefore resumes every group exactly at its cursor.
+    //
+    // Frames: [body size u32][type u8][body], integers little endian like EventBatchCodec.
+    //   FRAME_EVENTS: [topic][partition u32][lane u32][lane position of the first event u64][EventBatchCodec frame]
+    //   FRAME_CURSORS: [topic][next message id u64][next sequence u64][group count u32]
+    //                  then per group [group id][partition count u32] and per partition [lane count u32][cursor u64...]
+    // Strings are [length u32][bytes]. The standby answers with the number of frames it applied so far, as a u64.
+    struct ReplicationConfig {
+        std::string host = "127.0.0.1";
+        uint16_t port = 0;
+        size_t max_batch_events = 1024; // per lane and round
+        std::chrono::microseconds idle_sleep{100}; // between rounds that found nothing to send
+        bool compress = false; // LZ compress event frames, only worth it when the link is slower than the CPU
+        std::chrono::milliseconds send_timeout{1000}; // a round the standby does not take within this disconnects it
+    };
+
+    // Primary side. Connects in the constructor and replicates on a thread of its own until destroyed.
+    // One sender per bus at a time. Before and after it the bus discards what reaches the replication groups.
+    // A standby that goes away, or stops reading for longer than send_timeout, never stalls the primary: the sender
+    // disconnects, the replication groups keep being drained and the events are discarded.
+    class ReplicationSender {
+    public:
+        ReplicationSender(EventBus& event_bus, const ReplicationConfig& config);
+        ~ReplicationSender();
+
+        ReplicationSender(const ReplicationSender&) = delete;
+        ReplicationSender& operator=(const ReplicationSender&) = delete;
+
+        [[nodiscard]] bool is_connected() const {
+            return connected_.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] size_t sent_frames() const {
+            return sent_frames_.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] size_t sent_events() const {
+            return sent_events_.load(std::memory_order_acquire);
+        }
+
+        // Frames the standby confirmed applying, sent_frames() - acknowledged_frames() is the replication lag
+        [[nodiscard]] size_t acknowledged_frames() const {
+            return acknowledged_frames_.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct ReplicatedTopic {
+            const Topic* topic;
+            const ConsumerGroup* replication_group;
+            std::vector<const ConsumerGroup*> consumer_groups; // every other group of the topic
+            std::string last_cursors; // body of the last FRAME_CURSORS sent, unchanged cursors are not sent again
+        };
+
+        void run();
+        // Appends the frames of one round to out and returns how many, 0 when there was nothing new
+        size_t collect_frames(ReplicatedTopic& replicated_topic, std::string& out);
+        void send_frames(const std::string& frames, size_t frame_count);
+        void read_acknowledgements();
+        void disconnect();
+
+        EventBus& event_bus_;
+        ReplicationConfig config_;
+        std::vector<ReplicatedTopic> topics_;
+        std::vector<Event> batch_; // sender thread only
+        size_t round_events_{0}; // sender thread only, events in the frames of the current round
+        std::string acknowledgement_buffer_; // sender thread only
+        int socket_fd_{-1};
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> connected_{false};
+        std::atomic<size_t> sent_frames_{0};
+        std::atomic<size_t> sent_events_{0};
+        std::atomic<size_t> acknowledged_frames_{0};
+        std::thread thread_;
+    };
+
+    struct StandbyConfig {
+        uint16_t port = 0; // on 127.0.0.1, 0 picks a free one, see StandbyReplica::port()
+    };
+
+    // Standby side. Listens in the constructor and applies frames of one primary on a thread of its own.
+    class StandbyReplica {
+    public:
+        explicit StandbyReplica(const StandbyConfig& config = {});
+        ~StandbyReplica();
+
+        StandbyReplica(const StandbyReplica&) = delete;
+        StandbyReplica& operator=(const StandbyReplica&) = delete;
+
+        [[nodiscard]] uint16_t port() const {
+            return port_;
+        }
+
+        [[nodiscard]] bool is_connected() const {
+            return connected_.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] size_t applied_frames() const {
+            return applied_frames_.load(std::memory_order_acquire);
+        }
+
+        // Stops replicating and restores what was replicated into event_bus, see EventBus::restore_snapshot.
+        // event_bus must be freshly built from the primary's config. Each group resumes at the last cursor the
+        // primary sent for it, a broadcast group at the cursor of its slowest consumer. Events the primary had not
+        // replicated yet are lost.
+        void take_over(EventBus& event_bus);
+
+    private:
+        struct LaneLog {
+            size_t base_position{0}; // lane position of events.front()
+            std::deque<Event> events;
+        };
+
+        using LaneCursors = std::vector<std::vector<size_t>>; // [partition][lane]
+
+        struct TopicLog {
+            size_t next_message_id{0};
+            size_t next_sequence{1};
+            std::vector<std::vector<LaneLog>> partitions; // [partition][lane]
+            std::unordered_map<std::string, LaneCursors> group_cursors;
+        };
+
+        void run();
+        // Applies every complete frame at the front of buffer and erases it, throws on a malformed frame
+        void apply_frames(std::string& buffer);
+        void apply_events(const char* body, size_t size);
+        void apply_cursors(const char* body, size_t size);
+        // Drops events every group of the topic is past
+        void trim(TopicLog& topic_log) const;
+        void stop();
+
+        StandbyConfig config_;
+        int listen_fd_{-1};
+        int connection_fd_{-1}; // receiving thread only
+        uint16_t port_{0};
+        std::mutex state_mutex_;
+        std::unordered_map<std::string, TopicLog> topics_; // guarded by state_mutex_
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> connected_{false};
+        std::atomic<size_t> applied_frames_{0};
+        std::thread thread_;
+    };
+}
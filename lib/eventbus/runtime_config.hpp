@@ -0,0 +1,29 @@
+#pragma once
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "back_pressure_strategy.hpp"
+
+namespace eventbus {
+    // Settings that can change while the bus is running. Unset fields keep their current value.
+    struct RuntimeConfigUpdate {
+        std::optional<BackPressureStrategy> back_pressure_strategy;
+        std::optional<int> spin_yield_threshold;
+        std::optional<std::chrono::microseconds> block_sleep_duration;
+        std::optional<std::chrono::milliseconds> timeout;
+        std::unordered_map<std::string, size_t> queue_capacity_by_topic; // applies to every group of the topic
+        std::unordered_map<std::string, size_t> queue_capacity_by_group; // wins over the topic setting
+    };
+
+    // Line based "key = value" file, '#' starts a comment. Recognized keys:
+    //   backpressure.strategy = DROP_NEWEST | BLOCK | SPIN | YIELDING_SPIN
+    //   backpressure.spin_yield_threshold = <int>
+    //   backpressure.block_sleep_us = <int>
+    //   backpressure.timeout_ms = <int>
+    //   topic.<topic name>.queue_capacity = <power of two, at least 2>
+    //   group.<group id>.queue_capacity = <power of two, at least 2>
+    RuntimeConfigUpdate parse_runtime_config_file(const std::string& path);
+    RuntimeConfigUpdate parse_runtime_config(const std::string& text);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "event.hpp"
+
+namespace eventbus {
+    struct LaneSnapshot {
+        size_t cursor{}; // events already consumed from this lane
+        std::vector<Event> pending_events; // undelivered events, oldest first
+    };
+
+    struct PartitionSnapshot {
+        std::vector<LaneSnapshot> lanes; // lane 0 is the shared lane, then isolated tenant lanes
+    };
+
+    struct ConsumerGroupSnapshot {
+        std::string group_id;
+        std::string topic_name;
+        std::vector<PartitionSnapshot> partitions;
+    };
+
+    struct TopicSnapshot {
+        std::string name;
+        size_t next_message_id{};
+        size_t next_sequence{1};
+    };
+
+    // In-flight state of a bus captured on controlled shutdown, reloaded into a fresh bus on startup
+    struct BusSnapshot {
+        std::vector<TopicSnapshot> topics;
+        std::vector<ConsumerGroupSnapshot> consumer_groups;
+    };
+
+    // Partitions are stored as compressed EventBatchCodec frames and the whole file is written/read in one go
+    void write_snapshot_file(const BusSnapshot& snapshot, const std::string& path);
+    BusSnapshot read_snapshot_file(const std::string& path);
+}
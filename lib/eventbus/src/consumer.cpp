@@ -1,28 +1,375 @@
 #include "consumer.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
 namespace eventbus {
-     Consumer::Consumer(ConsumerGroup& consumer_group) {
+     Consumer::Consumer(ConsumerGroup& consumer_group) : acknowledged_(consumer_group.is_acknowledged()) {
         consumer_id_ = consumer_group.register_consumer(this);
      }
 
-     void Consumer::receive_queues(const std::vector<std::shared_ptr<LockFreeMpscQueue<Event>>>& queues) {
+     void Consumer::receive_queues(const std::vector<std::shared_ptr<PartitionQueue>>& queues) {
          queues_ = queues;
      }
 
-    // implemented batching by  division approach. Dividing max_events by the queue size. If any remainder, add
-    // one to each of the queue until remainder is exhausted
+     void Consumer::add_queues(const std::vector<std::shared_ptr<PartitionQueue>>& queues) {
+         std::lock_guard<std::mutex> lock(added_queues_mutex_);
+         if (notifier_ != nullptr) {
+             // Before publishers can route into them, see ConsumerGroup::add_partitions
+             for (const auto& queue : queues) {
+                 queue->set_notifier(notifier_.get());
+             }
+         }
+         added_queues_.insert(added_queues_.end(), queues.begin(), queues.end());
+         has_added_queues_.store(true, std::memory_order_release);
+     }
+
+     void Consumer::adopt_added_queues() const {
+         if (!has_added_queues_.load(std::memory_order_acquire)) {
+             return;
+         }
+         std::lock_guard<std::mutex> lock(added_queues_mutex_);
+         queues_.insert(queues_.end(), added_queues_.begin(), added_queues_.end());
+         added_queues_.clear();
+         has_added_queues_.store(false, std::memory_order_relaxed);
+     }
+
+     int Consumer::enable_notification() {
+         std::lock_guard<std::mutex> lock(added_queues_mutex_);
+         if (notifier_ == nullptr) {
+             notifier_ = std::make_unique<ConsumerNotifier>();
+             for (const auto& queue : queues_) {
+                 queue->set_notifier(notifier_.get());
+             }
+             for (const auto& queue : added_queues_) {
+                 queue->set_notifier(notifier_.get());
+             }
+         }
+         return notifier_->fd();
+     }
+
+     bool Consumer::arm_notification() const {
+         if (notifier_ == nullptr) {
+             throw std::runtime_error("Notification is not enabled for consumer - " + consumer_id_);
+         }
+         notifier_->clear();
+         notifier_->arm();
+         if (has_pending_events()) {
+             notifier_->disarm();
+             return false;
+         }
+         return true;
+     }
+
+     bool Consumer::has_pending_events() const {
+         if (has_added_queues_.load(std::memory_order_acquire) || !merge_heap_.empty() || !sequence_heap_.empty()) {
+             return true;
+         }
+         // Events behind a closed repartition fence do not count, the cut lanes wake the consumer once it can open
+         for (const auto& queue : queues_) {
+             if (queue->size_approx() != 0 && queue->is_open()) {
+                 return true;
+             }
+         }
+         return false;
+     }
+
     [[nodiscard]] const std::vector<Event>& Consumer::poll_batch(const size_t max_events) const {
+         adopt_added_queues();
+         batch_buffer_.clear();
+         delivered_runs_.clear();
+         if (queues_.empty() || max_events == 0) {
+             return batch_buffer_;
+         }
+         batch_buffer_.reserve(max_events);
+         drain_into_batch(max_events);
+         return batch_buffer_;
+     }
+
+    [[nodiscard]] const std::vector<Event>& Consumer::poll_batch(const size_t max_events, const size_t min_events,
+        const std::chrono::microseconds max_wait) const {
+         adopt_added_queues();
+         batch_buffer_.clear();
+         delivered_runs_.clear();
+         if (queues_.empty() || max_events == 0) {
+             return batch_buffer_;
+         }
+         batch_buffer_.reserve(max_events);
+         const size_t target_events = min_events < max_events ? min_events : max_events;
+
+         drain_into_batch(max_events);
+         if (batch_buffer_.size() >= target_events) {
+             return batch_buffer_;
+         }
+
+         const auto deadline = std::chrono::steady_clock::now() + max_wait;
+         int idle_rounds = 0;
+         while (batch_buffer_.size() < target_events) {
+             if (drain_into_batch(max_events - batch_buffer_.size()) != 0) {
+                 idle_rounds = 0;
+                 continue;
+             }
+             const auto now = std::chrono::steady_clock::now();
+             if (now >= deadline) {
+                 break;
+             }
+             ++idle_rounds;
+             if (idle_rounds <= POLL_SPIN_ROUNDS) {
+                 continue;
+             }
+             if (idle_rounds <= POLL_SPIN_ROUNDS + POLL_YIELD_ROUNDS) {
+                 std::this_thread::yield();
+                 continue;
+             }
+             const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now);
+             std::this_thread::sleep_for(remaining < POLL_PARK_DURATION ? remaining : POLL_PARK_DURATION);
+         }
+         return batch_buffer_;
+     }
+
+    void Consumer::set_adaptive_batching(const AdaptiveBatchConfig& config) {
+         if (config.min_batch == 0 || config.min_batch > config.max_batch) {
+             throw std::runtime_error("Adaptive batching of consumer - " + consumer_id_ + " needs 0 < min_batch <= max_batch");
+         }
+         adaptive_config_ = config;
+         adaptive_batch_size_ = config.min_batch;
+         handler_ns_per_event_ = 0;
+         last_batch_size_ = 0;
+     }
+
+    [[nodiscard]] const std::vector<Event>& Consumer::poll_adaptive_batch() const {
+         size_t depth = 0;
+         for (const auto& queue : queues_) {
+             depth += queue->size_approx();
+         }
+         size_t desired = depth;
+         if (handler_ns_per_event_ > 0) {
+             const double budget = static_cast<double>(adaptive_config_.latency_target.count()) / handler_ns_per_event_;
+             if (budget < static_cast<double>(desired)) {
+                 desired = static_cast<size_t>(budget);
+             }
+         }
+         desired = std::clamp(desired, adaptive_config_.min_batch, adaptive_config_.max_batch);
+
+         // At most double or halve per poll so a single odd sample does not swing the batch size
+         if (desired > adaptive_batch_size_) {
+             adaptive_batch_size_ = std::min(desired, adaptive_batch_size_ * 2);
+         } else {
+             adaptive_batch_size_ = std::max(desired, adaptive_batch_size_ / 2);
+         }
+
+         const auto& batch = poll_batch(adaptive_batch_size_);
+         last_batch_size_ = batch.size();
+         last_poll_returned_at_ = std::chrono::steady_clock::now();
+         return batch;
+     }
+
+    void Consumer::adaptive_batch_handled() const {
+         if (last_batch_size_ == 0) {
+             return; // empty batch, or already reported
+         }
+         const double sample = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - last_poll_returned_at_).count()) / static_cast<double>(last_batch_size_);
+         handler_ns_per_event_ = handler_ns_per_event_ == 0 ? sample : handler_ns_per_event_ * 0.875 + sample * 0.125;
+         last_batch_size_ = 0;
+     }
+
+    void Consumer::set_merge_ordering(const MergeConfig& config) {
+         if (config.lookahead == 0) {
+             throw std::runtime_error("Merge ordering of consumer - " + consumer_id_ + " needs a lookahead of at least one event");
+         }
+         merge_config_ = config;
+     }
+
+    [[nodiscard]] const std::vector<Event>& Consumer::poll_merged_batch(const size_t max_events) const {
+         if (acknowledged_) {
+             throw std::runtime_error("Merged polls are not available to consumer - " + consumer_id_ +
+                 " of an acknowledged group");
+         }
+         adopt_added_queues();
          batch_buffer_.clear();
          if (queues_.empty() || max_events == 0) {
              return batch_buffer_;
          }
          batch_buffer_.reserve(max_events);
+         switch (merge_config_.order) {
+             case MergeOrder::TIMESTAMP:
+                 merge_by_timestamp(max_events);
+                 break;
+             case MergeOrder::SEQUENCE:
+                 merge_by_sequence(max_events);
+                 break;
+         }
+         return batch_buffer_;
+     }
+
+    // Only the oldest staged event of every queue sits on the heap, so each emitted event costs one pop and at
+    // most one push over k = number of assigned queues. An event is emitted once every queue has something staged
+    // to compare against, or once it is older than max_skew and a queue with nothing staged is assumed idle.
+    void Consumer::merge_by_timestamp(const size_t max_events) const {
+         if (merge_staging_.size() != queues_.size()) {
+             merge_staging_.resize(queues_.size()); // added partitions come last, staged events stay where they are
+             merge_read_.resize(queues_.size(), 0);
+         }
+
+         for (size_t i = 0; i < queues_.size(); ++i) {
+             if (merge_read_[i] == merge_staging_[i].size()) {
+                 stage_merge_queue(i);
+             }
+         }
+
+         const auto skew_cutoff = std::chrono::steady_clock::now() - merge_config_.max_skew;
+         while (batch_buffer_.size() < max_events && !merge_heap_.empty()) {
+             const MergeHead head = merge_heap_.top();
+             if (merge_heap_.size() < queues_.size() && head.timestamp > skew_cutoff) {
+                 break; // an idle queue may still deliver something older
+             }
+             merge_heap_.pop();
+             std::vector<Event>& staging = merge_staging_[head.queue_index];
+             batch_buffer_.push_back(std::move(staging[merge_read_[head.queue_index]++]));
+             if (merge_read_[head.queue_index] == staging.size()) {
+                 stage_merge_queue(head.queue_index);
+             } else {
+                 merge_heap_.push({staging[merge_read_[head.queue_index]].timestamp, head.queue_index});
+             }
+         }
+     }
 
+    // Sequences are gap free, so the smallest staged one can go as soon as it is the next one expected, no matter
+    // how many queues have nothing staged. Two producers may stamp and enqueue in opposite order, so a ring is not
+    // sorted by sequence: every staged event sits on the heap, not just the front of each queue.
+    // While the next sequence is missing every queue is drained by another lookahead per poll: it may sit deeper
+    // in a ring, or its producer may be blocked on a ring full of later sequences. Events dropped by back-pressure
+    // and sequences routed to partitions this consumer does not read never show up, that gap is waited out for
+    // max_skew and then skipped.
+    void Consumer::merge_by_sequence(const size_t max_events) const {
+         if (sequence_staged_.size() != queues_.size()) {
+             sequence_staged_.resize(queues_.size(), 0);
+         }
+         for (size_t i = 0; i < queues_.size(); ++i) {
+             const size_t staged = sequence_staged_[i];
+             stage_sequence_queue(i, staged < merge_config_.lookahead ? merge_config_.lookahead - staged : 0);
+         }
+
+         bool drained_for_gap = false;
+         while (batch_buffer_.size() < max_events && !sequence_heap_.empty()) {
+             const size_t sequence = sequence_heap_.front().sequence;
+             if (sequence > next_sequence_) {
+                 if (!drained_for_gap) {
+                     drained_for_gap = true;
+                     for (size_t i = 0; i < queues_.size(); ++i) {
+                         stage_sequence_queue(i, merge_config_.lookahead);
+                     }
+                     continue;
+                 }
+                 const auto now = std::chrono::steady_clock::now();
+                 if (!sequence_gap_open_) {
+                     sequence_gap_open_ = true;
+                     sequence_gap_since_ = now;
+                 }
+                 if (now - sequence_gap_since_ < merge_config_.max_skew) {
+                     break; // the missing one may still be on its way
+                 }
+             }
+             sequence_gap_open_ = false;
+             if (sequence >= next_sequence_) {
+                 next_sequence_ = sequence + 1; // late arrivals below it (and NO_SEQUENCE) go out right away
+             }
+             std::pop_heap(sequence_heap_.begin(), sequence_heap_.end(), std::greater<>());
+             const SequenceHead head = sequence_heap_.back();
+             sequence_heap_.pop_back();
+             batch_buffer_.push_back(std::move(sequence_slots_[head.slot]));
+             free_sequence_slots_.push_back(head.slot);
+             const size_t queue_index = head.queue_index;
+             if (--sequence_staged_[queue_index] == 0) {
+                 stage_sequence_queue(queue_index, merge_config_.lookahead);
+             }
+         }
+     }
+
+    void Consumer::stage_sequence_queue(const size_t queue_index, const size_t max_events) const {
+         if (max_events == 0) {
+             return;
+         }
+         sequence_scratch_.clear();
+         const size_t taken = queues_[queue_index]->dequeue_batch(sequence_scratch_, max_events, prefetch_distance_);
+         for (Event& event : sequence_scratch_) {
+             size_t slot = sequence_slots_.size();
+             if (free_sequence_slots_.empty()) {
+                 sequence_slots_.push_back(std::move(event));
+             } else {
+                 slot = free_sequence_slots_.back();
+                 free_sequence_slots_.pop_back();
+                 sequence_slots_[slot] = std::move(event);
+             }
+             sequence_heap_.push_back({sequence_slots_[slot].sequence, queue_index, slot});
+             std::push_heap(sequence_heap_.begin(), sequence_heap_.end(), std::greater<>());
+         }
+         sequence_staged_[queue_index] += taken;
+     }
+
+    void Consumer::stage_merge_queue(const size_t queue_index) const {
+         std::vector<Event>& staging = merge_staging_[queue_index];
+         staging.clear();
+         merge_read_[queue_index] = 0;
+         if (queues_[queue_index]->dequeue_batch(staging, merge_config_.lookahead, prefetch_distance_) != 0) {
+             merge_heap_.push({staging.front().timestamp, queue_index});
+         }
+     }
+
+    void Consumer::acknowledge() const {
+         require_acknowledged();
+         for (const auto& queue : queues_) {
+             queue->acknowledge();
+         }
+     }
+
+    void Consumer::acknowledge(const Event& event) const {
+         require_acknowledged();
+         const Event* first = batch_buffer_.data();
+         if (&event < first || &event >= first + batch_buffer_.size()) {
+             throw std::runtime_error("Consumer - " + consumer_id_ + " acknowledges single events of its last batch only");
+         }
+         const size_t index = static_cast<size_t>(&event - first);
+         // Runs are in batch order, the event belongs to the last one starting at or before it
+         const auto run = std::prev(std::upper_bound(delivered_runs_.begin(), delivered_runs_.end(), index,
+             [](const size_t batch_index, const DeliveredRun& delivered) { return batch_index < delivered.first_index; }));
+         run->lane->acknowledge(run->first_position + (index - run->first_index) + 1, run->reader);
+     }
+
+    void Consumer::redeliver_unacknowledged() const {
+         require_acknowledged();
+         adopt_added_queues();
+         for (const auto& queue : queues_) {
+             queue->redeliver();
+         }
+         batch_buffer_.clear(); // whatever it held comes again
+         delivered_runs_.clear();
+     }
+
+    void Consumer::require_acknowledged() const {
+         if (!acknowledged_) {
+             throw std::runtime_error("Consumer - " + consumer_id_ + " does not belong to an acknowledged group");
+         }
+     }
+
+    size_t Consumer::poll_partition(const size_t assigned_index, std::vector<Event>& out, const size_t max_events,
+        std::vector<DeliveredRun>* runs) const {
+         return queues_[assigned_index]->dequeue_batch(out, max_events, prefetch_distance_, runs);
+     }
+
+    // implemented batching by  division approach. Dividing max_events by the queue size. If any remainder, add
+    // one to each of the queue until remainder is exhausted
+    size_t Consumer::drain_into_batch(const size_t max_events) const {
          const size_t num_queues = queues_.size();
          const size_t events_per_queue = max_events / num_queues;
          size_t remainder = max_events % num_queues;
+         size_t total_taken = 0;
 
-         for (size_t q_idx = 0; q_idx < num_queues; ++q_idx) {
+         for (size_t i = 0; i < num_queues; ++i) {
+             const size_t q_idx = (next_queue_ + i) % num_queues;
              // Calculate how many events to take from this queue
              size_t events_to_take = events_per_queue;
              if (remainder > 0) {
@@ -31,16 +378,12 @@ namespace eventbus {
              }
 
              // Take events from this queue
-             size_t taken = 0;
-             while (taken < events_to_take) {
-                 if (Event event; queues_[q_idx]->dequeue(event)) {
-                     batch_buffer_.push_back(std::move(event));
-                     taken++;
-                 } else {
-                     break;  // No more events in this queue
-                 }
+             if (events_to_take != 0) {
+                 total_taken += queues_[q_idx]->dequeue_batch(batch_buffer_, events_to_take, prefetch_distance_,
+                     acknowledged_ ? &delivered_runs_ : nullptr);
              }
          }
-         return batch_buffer_;
+         next_queue_ = (next_queue_ + 1) % num_queues;
+         return total_taken;
      }
 }
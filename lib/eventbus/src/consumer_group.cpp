@@ -1,13 +1,33 @@
 #include "consumer_group.hpp"
 
-#include "back_pressure_strategy.hpp"
 #include "consumer.hpp"
 
 namespace eventbus {
     ConsumerGroup::ConsumerGroup(std::string group_id,
-        const size_t partition_count):
+        const size_t partition_count, const size_t queue_capacity, std::vector<size_t> isolated_lane_capacities,
+        const QueueEngine queue_engine, const RingAllocation& ring_allocation, const bool broadcast, const bool acknowledged):
     group_id_(std::move(group_id)),
-    topic_partition_count_(partition_count) {}
+    topic_partition_count_(partition_count),
+    queue_capacity_(queue_capacity),
+    isolated_lane_capacities_(std::move(isolated_lane_capacities)),
+    queue_engine_(broadcast || acknowledged ? QueueEngine::BROADCAST_RING : queue_engine),
+    ring_allocation_(ring_allocation),
+    broadcast_(broadcast),
+    acknowledged_(acknowledged),
+    partition_queues_(std::make_unique<std::vector<std::shared_ptr<PartitionQueue>>>()) {
+        if (queue_capacity_ < EventRing::MIN_CAPACITY || (queue_capacity_ & (queue_capacity_ - 1)) != 0) {
+            throw std::runtime_error("Queue capacity of consumer group - " + group_id_ + " must be a power of two of at least " +
+                std::to_string(EventRing::MIN_CAPACITY) + ", got " + std::to_string(queue_capacity_));
+        }
+        // A ring that never reports full never grows. RELAXED_RING lanes split their ring further, RelaxedMpscQueue
+        // keeps them at MIN_LANE_CAPACITY slots or more by using fewer of them.
+        const size_t initial_capacity = ring_allocation_.initial_capacity;
+        if (initial_capacity != 0 && (initial_capacity < EventRing::MIN_CAPACITY ||
+            (initial_capacity & (initial_capacity - 1)) != 0 || initial_capacity > queue_capacity_)) {
+            throw std::runtime_error("Initial queue capacity of consumer group - " + group_id_ + " must be a power of two of at least " +
+                std::to_string(EventRing::MIN_CAPACITY) + " and no larger than the queue capacity, got " + std::to_string(initial_capacity));
+        }
+    }
 
     std::string ConsumerGroup::register_consumer(Consumer* consumer) {
         const size_t consumer_index = assigned_consumers_.size();
@@ -25,16 +45,13 @@ namespace eventbus {
             throw std::runtime_error("No consumers registered for - " + group_id_);
         }
 
-        // Round-robin way of assignment when partition_count > consumer_group_size
-        // For example, we have 5 partition and 2 as group size
-        // This is how the assignment will be
-        // 0 -> 0, 2, 4 and 1 -> 1, 3
+        auto partition_queues = std::make_unique<std::vector<std::shared_ptr<PartitionQueue>>>();
         for (size_t i = 0; i < topic_partition_count_; ++i) {
-            auto partition_queue = std::make_shared<LockFreeMpscQueue<Event>>(16384);
-            partition_queues_.push_back(partition_queue);
-            queue_assignments_by_consumer_index_[i % assigned_consumers_.size()]
-            .push_back(partition_queue);
+            auto partition_queue = make_partition_queue(false);
+            partition_queues->push_back(partition_queue);
+            assign_partition(i, partition_queue, queue_assignments_by_consumer_index_);
         }
+        partition_queues_.update(std::move(partition_queues));
 
         for (size_t i = 0; i < assigned_consumers_.size(); ++i) {
             if (queue_assignments_by_consumer_index_.find(i) == queue_assignments_by_consumer_index_.end()) {
@@ -46,10 +63,128 @@ namespace eventbus {
         finalized_consumer_group_ = true;
     }
 
-    bool ConsumerGroup::deliver_event_to_consumer_group(const Event& event, const size_t partition_index, const BackPressureHandler& back_pressure_handler) const {
-        const auto partition_queue = partition_queues_[partition_index];
-        const bool can_enqueue = back_pressure_handler.try_enqueue_with_backpressure_strategy(partition_queue, event);
-        return can_enqueue;
+    std::vector<PartitionSnapshot> ConsumerGroup::snapshot_partitions() const {
+        const auto& partition_queues = this->partition_queues();
+        std::vector<PartitionSnapshot> partitions(partition_queues.size());
+        for (size_t i = 0; i < partition_queues.size(); ++i) {
+            const auto& partition_queue = partition_queues[i];
+            partitions[i].lanes.resize(partition_queue->lane_count());
+            for (size_t lane_index = 0; lane_index < partition_queue->lane_count(); ++lane_index) {
+                // A broadcast lane is saved from its slowest reader, faster readers see some events again on restore.
+                // An acknowledged lane from its commit cursor, unacknowledged events are delivered again.
+                LaneSnapshot& lane = partitions[i].lanes[lane_index];
+                const PartitionLane* partition_lane = partition_queue->lane(lane_index);
+                const size_t reader = partition_lane->slowest_reader();
+                lane.cursor = partition_lane->consumed_position(reader);
+                partition_lane->for_each_pending([&](const Event& event) {
+                    lane.pending_events.push_back(event);
+                }, reader);
+            }
+        }
+        return partitions;
     }
 
+    void ConsumerGroup::restore_partitions(const std::vector<PartitionSnapshot>& partitions) {
+        const auto& partition_queues = this->partition_queues();
+        if (partitions.size() != partition_queues.size()) {
+            throw std::runtime_error("Snapshot of consumer group - " + group_id_ + " has " +
+                std::to_string(partitions.size()) + " partitions, expected " + std::to_string(partition_queues.size()));
+        }
+        for (size_t i = 0; i < partitions.size(); ++i) {
+            const auto& partition_queue = partition_queues[i];
+            if (partitions[i].lanes.size() != partition_queue->lane_count()) {
+                throw std::runtime_error("Snapshot of consumer group - " + group_id_ + " has a different tenant lane layout");
+            }
+            for (size_t lane_index = 0; lane_index < partition_queue->lane_count(); ++lane_index) {
+                PartitionLane* lane = partition_queue->lane(lane_index);
+                lane->reset_position(partitions[i].lanes[lane_index].cursor);
+                for (const auto& event : partitions[i].lanes[lane_index].pending_events) {
+                    if (!lane->enqueue(event)) {
+                        throw std::runtime_error("Snapshot of consumer group - " + group_id_ + " does not fit partition queue");
+                    }
+                }
+            }
+        }
+    }
+
+    void ConsumerGroup::migrate_partition_queues(const size_t queue_capacity) {
+        if (has_isolated_lanes()) {
+            throw std::runtime_error("Queue capacity of consumer group - " + group_id_ +
+                " cannot change, its partitions have isolated tenant lanes");
+        }
+        for (const auto& partition_queue : partition_queues()) {
+            partition_queue->lane(0)->resize(queue_capacity);
+        }
+        queue_capacity_ = queue_capacity;
+    }
+
+    void ConsumerGroup::add_partitions(const size_t partition_count) {
+        auto partition_queues = std::make_unique<std::vector<std::shared_ptr<PartitionQueue>>>(this->partition_queues());
+        QueueAssignments added_by_consumer_index;
+        for (size_t i = partition_queues->size(); i < partition_count; ++i) {
+            auto partition_queue = make_partition_queue(true);
+            partition_queues->push_back(partition_queue);
+            assign_partition(i, partition_queue, added_by_consumer_index);
+        }
+        partition_queues_.update(std::move(partition_queues));
+        topic_partition_count_ = partition_count;
+
+        for (const auto& [consumer_index, queues] : added_by_consumer_index) {
+            auto& assigned_queues = queue_assignments_by_consumer_index_[consumer_index];
+            assigned_queues.insert(assigned_queues.end(), queues.begin(), queues.end());
+            assigned_consumers_[consumer_index]->add_queues(queues);
+        }
+    }
+
+    // A key that moved can only have come from one of the old partitions, and jump hashing never moves keys
+    // between old partitions, so every added partition waits for all old lanes to pass the current cut
+    void ConsumerGroup::fence_added_partitions(const size_t old_partition_count) const {
+        const auto& partition_queues = this->partition_queues();
+        std::vector<FenceCut> cuts;
+        for (size_t i = 0; i < old_partition_count; ++i) {
+            for (size_t lane_index = 0; lane_index < partition_queues[i]->lane_count(); ++lane_index) {
+                PartitionLane* lane = partition_queues[i]->lane(lane_index);
+                cuts.push_back({lane, lane->enqueue_position()});
+            }
+        }
+        if (broadcast_) {
+            // Every consumer holds a view of every partition, in partition order, and each view has its own fence
+            for (const auto& [consumer_index, queues] : queue_assignments_by_consumer_index_) {
+                for (size_t i = old_partition_count; i < queues.size(); ++i) {
+                    queues[i]->set_fence_cuts(cuts);
+                }
+            }
+            return;
+        }
+        for (size_t i = old_partition_count; i < partition_queues.size(); ++i) {
+            partition_queues[i]->set_fence_cuts(cuts);
+        }
+    }
+
+    std::shared_ptr<PartitionQueue> ConsumerGroup::make_partition_queue(const bool fenced) const {
+        const size_t reader_count = broadcast_ ? assigned_consumers_.size() : 1;
+        auto partition_queue = std::make_shared<PartitionQueue>(queue_capacity_, queue_engine_, ring_allocation_, fenced,
+            reader_count, acknowledged_);
+        for (const size_t lane_capacity : isolated_lane_capacities_) {
+            partition_queue->add_lane(lane_capacity);
+        }
+        return partition_queue;
+    }
+
+    // Round-robin way of assignment when partition_count > consumer_group_size
+    // For example, we have 5 partition and 2 as group size
+    // This is how the assignment will be
+    // 0 -> 0, 2, 4 and 1 -> 1, 3
+    // A broadcast group gives every consumer every partition, consumer i reads it as reader i
+    void ConsumerGroup::assign_partition(const size_t partition_index, const std::shared_ptr<PartitionQueue>& partition_queue,
+        QueueAssignments& assignments) const {
+        if (!broadcast_) {
+            assignments[partition_index % assigned_consumers_.size()].push_back(partition_queue);
+            return;
+        }
+        for (size_t consumer_index = 0; consumer_index < assigned_consumers_.size(); ++consumer_index) {
+            assignments[consumer_index].push_back(consumer_index == 0 ? partition_queue :
+                partition_queue->reader_view(consumer_index));
+        }
+    }
 }
@@ -0,0 +1,35 @@
+#include "consumer_notifier.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace eventbus {
+    ConsumerNotifier::ConsumerNotifier() : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        if (fd_ < 0) {
+            throw std::runtime_error(std::string("Consumer notifier - eventfd failed: ") + std::strerror(errno));
+        }
+    }
+
+    ConsumerNotifier::~ConsumerNotifier() {
+        close(fd_);
+    }
+
+    void ConsumerNotifier::clear() const {
+        uint64_t count = 0;
+        while (read(fd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+        }
+        // EAGAIN: nothing was signaled
+    }
+
+    void ConsumerNotifier::signal() const {
+        const uint64_t one = 1;
+        while (write(fd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+        // EAGAIN only happens once the counter is near overflow, the fd is readable then anyway
+    }
+}
@@ -0,0 +1,163 @@
+#include "parallel_consumer.hpp"
+
+#include <stdexcept>
+
+namespace eventbus {
+    namespace {
+        bool is_power_of_two(const size_t value) {
+            return value != 0 && (value & (value - 1)) == 0;
+        }
+    }
+
+    ParallelConsumer::ParallelConsumer(const Consumer& consumer, Handler handler, const ParallelConsumerConfig& config) :
+    consumer_(consumer),
+    handler_(std::move(handler)),
+    config_(config) {
+        if (config_.worker_count == 0) {
+            throw std::runtime_error("Parallel consumer - " + consumer_.consumer_id() + " needs at least one worker");
+        }
+        if (!is_power_of_two(config_.worker_queue_capacity) || !is_power_of_two(config_.max_in_flight_per_partition)) {
+            throw std::runtime_error("Parallel consumer - " + consumer_.consumer_id() +
+                " worker queue capacity and in-flight window must be powers of two");
+        }
+        track_assigned_partitions();
+        for (size_t i = 0; i < config_.worker_count; ++i) {
+            workers_.push_back(std::make_unique<Worker>(config_.worker_queue_capacity));
+        }
+        for (const auto& worker : workers_) {
+            worker->thread = std::thread(&ParallelConsumer::run_worker, this, std::ref(*worker));
+        }
+    }
+
+    ParallelConsumer::~ParallelConsumer() {
+        running_.store(false, std::memory_order_release);
+        for (const auto& worker : workers_) {
+            worker->thread.join();
+        }
+        for (size_t assigned_index = 0; assigned_index < progress_.size(); ++assigned_index) {
+            completed_position(assigned_index); // commits what the workers finished last
+        }
+    }
+
+    size_t ParallelConsumer::poll_and_dispatch(const size_t max_events) {
+        if (failed_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(failure_mutex_);
+            std::rethrow_exception(failure_);
+        }
+        track_assigned_partitions();
+
+        size_t dispatched = 0;
+        const size_t window = config_.max_in_flight_per_partition;
+        for (size_t assigned_index = 0; assigned_index < progress_.size() && dispatched < max_events; ++assigned_index) {
+            PartitionProgress& progress = *progress_[assigned_index];
+            completed_position(assigned_index);
+            // Never take more than the window has room for, the rest stays in the ring
+            const size_t room = window - (progress.dispatched - progress.completed);
+            const size_t wanted = std::min(room, max_events - dispatched);
+            if (wanted == 0) {
+                continue;
+            }
+
+            poll_buffer_.clear();
+            poll_runs_.clear();
+            consumer_.poll_partition(assigned_index, poll_buffer_, wanted, progress.origins ? &poll_runs_ : nullptr);
+            size_t run_index = 0;
+            for (size_t i = 0; i < poll_buffer_.size(); ++i) {
+                Event& event = poll_buffer_[i];
+                const size_t sequence = progress.dispatched++;
+                if (progress.origins) {
+                    while (run_index + 1 < poll_runs_.size() && poll_runs_[run_index + 1].first_index <= i) {
+                        ++run_index;
+                    }
+                    const DeliveredRun& run = poll_runs_[run_index];
+                    progress.origins[sequence & (window - 1)] = {run.lane, run.reader, run.first_position + (i - run.first_index)};
+                }
+                Worker& worker = *workers_[pick_worker(event, sequence)];
+                in_flight_.fetch_add(1, std::memory_order_relaxed);
+                Task task{std::move(event), &progress, sequence};
+                while (!worker.tasks.enqueue(std::move(task))) {
+                    std::this_thread::yield(); // worker is behind, it keeps draining
+                }
+            }
+            dispatched += poll_buffer_.size();
+        }
+        return dispatched;
+    }
+
+    // Within a lane events are dispatched in lane order, so once the watermark passes an event every earlier event
+    // of its lane is handled too, and acknowledging the lane up to it commits handled events only
+    size_t ParallelConsumer::completed_position(const size_t assigned_index) {
+        PartitionProgress& progress = *progress_[assigned_index];
+        const size_t mask = config_.max_in_flight_per_partition - 1;
+        const Origin* pending = nullptr; // last completed event of a lane, acknowledged when the lane changes
+        while (progress.completed != progress.dispatched &&
+               progress.done[progress.completed & mask].load(std::memory_order_acquire)) {
+            progress.done[progress.completed & mask].store(false, std::memory_order_relaxed);
+            if (progress.origins) {
+                const Origin* origin = &progress.origins[progress.completed & mask];
+                if (pending != nullptr && pending->lane != origin->lane) {
+                    pending->lane->acknowledge(pending->position + 1, pending->reader);
+                }
+                pending = origin;
+            }
+            ++progress.completed;
+        }
+        if (pending != nullptr) {
+            pending->lane->acknowledge(pending->position + 1, pending->reader);
+        }
+        return progress.completed;
+    }
+
+    bool ParallelConsumer::idle() const {
+        return in_flight_.load(std::memory_order_acquire) == 0;
+    }
+
+    void ParallelConsumer::run_worker(Worker& worker) {
+        const size_t mask = config_.max_in_flight_per_partition - 1;
+        Task task;
+        int idle_rounds = 0;
+        while (true) {
+            if (worker.tasks.dequeue(task)) {
+                idle_rounds = 0;
+                try {
+                    handler_(task.event);
+                    task.progress->done[task.sequence & mask].store(true, std::memory_order_release);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(failure_mutex_);
+                    if (!failure_) {
+                        failure_ = std::current_exception();
+                    }
+                    failed_.store(true, std::memory_order_release);
+                }
+                in_flight_.fetch_sub(1, std::memory_order_release);
+                continue;
+            }
+            if (!running_.load(std::memory_order_acquire)) {
+                return; // stop is only requested after the dispatcher is done, so the queue stays empty now
+            }
+            if (++idle_rounds < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    // Partitions added by a repartition are appended to the consumer's assignment, so indexes stay stable
+    void ParallelConsumer::track_assigned_partitions() {
+        consumer_.adopt_added_queues();
+        while (progress_.size() < consumer_.assigned_partition_count()) {
+            progress_.push_back(std::make_unique<PartitionProgress>(config_.max_in_flight_per_partition,
+                consumer_.is_acknowledged()));
+        }
+    }
+
+    // Mixes the key hash first, partitioning already used its low bits
+    size_t ParallelConsumer::pick_worker(const Event& event, const size_t sequence) const {
+        if (event.key_hash == Event::NO_KEY) {
+            return sequence % workers_.size();
+        }
+        const uint64_t mixed = static_cast<uint64_t>(event.key_hash) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(mixed >> 32) % workers_.size();
+    }
+}
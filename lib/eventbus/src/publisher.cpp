@@ -0,0 +1,136 @@
+#include "publisher.hpp"
+
+#include "event_bus.hpp"
+
+namespace eventbus {
+    Publisher::Publisher(EventBus& event_bus, const PublisherConfig& config) :
+    event_bus_(event_bus),
+    config_(config),
+    tenant_index_(EventBus::NO_TENANT),
+    lane_index_(0) {}
+
+    Publisher::Publisher(EventBus& event_bus, const TenantTag tenant_tag, const PublisherConfig& config) :
+    event_bus_(event_bus),
+    config_(config),
+    tenant_index_(tenant_tag.index),
+    lane_index_(event_bus.tenants_[tenant_tag.index]->lane_index()) {}
+
+    Publisher::~Publisher() {
+        flush();
+    }
+
+    bool Publisher::publish(Event event, const std::string& partition_key) {
+        if (tenant_index_ != EventBus::NO_TENANT && !event_bus_.tenants_[tenant_index_]->try_acquire_publish()) {
+            return false; // over quota, dropped like a full queue
+        }
+        auto buffers_it = buffers_by_topic_.find(event.topic);
+        if (buffers_it == buffers_by_topic_.end()) {
+            buffers_it = buffers_by_topic_.try_emplace(event.topic,
+                TopicBuffers{&event_bus_.topic_for_publish(event.topic), {}}).first;
+        }
+        TopicBuffers& topic_buffers = buffers_it->second;
+        Topic& topic = *topic_buffers.topic;
+        size_t partition_index = 0;
+        {
+            // Least loaded routing reads the depth of rings a reload may retire and free, see publish_to_topic()
+            const GracePeriod::ReadGuard routing_guard(topic.routing_grace_period());
+            if (!event_bus_.assign_event_partition(topic, event, partition_key, lane_index_, partition_index)) {
+                return false;
+            }
+        }
+
+        PartitionBuffers& partition_buffers = topic_buffers.partitions;
+        // Counts only grow and the buffers were sized before the event got routed, so when they still match the
+        // current count the event was routed with that count as well
+        const size_t partition_count = topic.partition_count();
+        if (partition_buffers.size() != partition_count) {
+            rebucket(partition_buffers, partition_count);
+            partition_index = EventBus::get_partition_index(event.id, partition_count, event.key_hash);
+        }
+        std::vector<Event>& buffer = partition_buffers[partition_index];
+        buffer.push_back(std::move(event));
+
+        const auto now = std::chrono::steady_clock::now();
+        if (buffered_events_++ == 0) {
+            oldest_buffered_at_ = now;
+        }
+
+        bool all_delivered = true;
+        if (buffer.size() >= config_.max_batch_events) {
+            all_delivered = flush_buffers(topic_buffers, partition_index);
+        }
+        if (buffered_events_ != 0 && now - oldest_buffered_at_ >= config_.max_batch_delay) {
+            all_delivered = flush() && all_delivered;
+        }
+        return all_delivered;
+    }
+
+    bool Publisher::flush() {
+        bool all_delivered = true;
+        for (auto& [topic_name, topic_buffers] : buffers_by_topic_) {
+            all_delivered = flush_buffers(topic_buffers, ALL_PARTITIONS) && all_delivered;
+        }
+        return all_delivered;
+    }
+
+    // Delivers one partition buffer, or all of them. If the topic was repartitioned since the events were buffered
+    // they are re-sorted first and everything goes, a single old buffer may now span several partitions.
+    bool Publisher::flush_buffers(TopicBuffers& topic_buffers, size_t partition_index) {
+        Topic& topic = *topic_buffers.topic;
+        PartitionBuffers& partition_buffers = topic_buffers.partitions;
+        const GracePeriod::ReadGuard routing_guard(topic.routing_grace_period()); // until the batches are enqueued
+        const size_t partition_count = topic.partition_count();
+        if (partition_buffers.size() != partition_count) {
+            rebucket(partition_buffers, partition_count);
+            partition_index = ALL_PARTITIONS;
+        }
+
+        const size_t first = partition_index == ALL_PARTITIONS ? 0 : partition_index;
+        const size_t last = partition_index == ALL_PARTITIONS ? partition_buffers.size() : partition_index + 1;
+        if (topic.total_order()) {
+            stamp_sequences(topic, partition_buffers, first, last);
+        }
+        bool all_delivered = true;
+        for (size_t i = first; i < last; ++i) {
+            std::vector<Event>& buffer = partition_buffers[i];
+            if (buffer.empty()) {
+                continue;
+            }
+            all_delivered = event_bus_.deliver_batch(topic, i, lane_index_, buffer) && all_delivered;
+            buffered_events_ -= buffer.size();
+            buffer.clear(); // keeps the capacity for the next batch
+        }
+        // oldest_buffered_at_ is left alone, it may now be older than what is left which only makes flushes earlier
+        return all_delivered;
+    }
+
+    // One reservation covers everything flushed. Sequences follow the buffers, so within a buffer they keep the
+    // publish order and the partition order; across buffers of one flush the consumer merge sorts them out.
+    void Publisher::stamp_sequences(Topic& topic, PartitionBuffers& partition_buffers, const size_t first, const size_t last) {
+        size_t count = 0;
+        for (size_t i = first; i < last; ++i) {
+            count += partition_buffers[i].size();
+        }
+        if (count == 0) {
+            return;
+        }
+        size_t sequence = topic.reserve_sequences(count);
+        for (size_t i = first; i < last; ++i) {
+            for (const Event& event : partition_buffers[i]) {
+                event.sequence = sequence++;
+            }
+        }
+    }
+
+    // Events of one key all sit in one buffer in publish order, walking the buffers in order keeps that order
+    // Keyless events only need some partition, they go round robin here whatever the topic's keyless partitioning
+    void Publisher::rebucket(PartitionBuffers& partition_buffers, const size_t partition_count) {
+        PartitionBuffers rebucketed(partition_count);
+        for (auto& buffer : partition_buffers) {
+            for (auto& event : buffer) {
+                rebucketed[EventBus::get_partition_index(event.id, partition_count, event.key_hash)].push_back(std::move(event));
+            }
+        }
+        partition_buffers = std::move(rebucketed);
+    }
+}
@@ -0,0 +1,546 @@
+#include "replication.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "event_codec.hpp"
+
+namespace eventbus {
+    namespace {
+        constexpr uint8_t FRAME_EVENTS = 1;
+        constexpr uint8_t FRAME_CURSORS = 2;
+        constexpr size_t FRAME_HEADER_SIZE = 4 + 1;
+        constexpr int POLL_INTERVAL_MS = 50; // how quickly the standby thread notices take_over()
+
+        void put_string(std::string& out, const std::string& value) {
+            EventBatchCodec::put_u32(out, static_cast<uint32_t>(value.size()));
+            out.append(value);
+        }
+
+        void append_frame(std::string& out, const uint8_t type, const std::string& body) {
+            EventBatchCodec::put_u32(out, static_cast<uint32_t>(body.size()));
+            out.push_back(static_cast<char>(type));
+            out.append(body);
+        }
+
+        // On a non-blocking socket, false once the peer has not taken everything within timeout or the socket broke
+        bool send_all(const int fd, const char* data, size_t size, const std::chrono::milliseconds timeout) {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (size != 0) {
+                const ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+                if (sent >= 0) {
+                    data += sent;
+                    size -= static_cast<size_t>(sent);
+                    continue;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    return false;
+                }
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                if (remaining.count() <= 0) {
+                    return false; // a standby that stopped reading must not stall the drain
+                }
+                pollfd writable{fd, POLLOUT, 0};
+                poll(&writable, 1, static_cast<int>(remaining.count()));
+            }
+            return true;
+        }
+
+        class FrameReader {
+        public:
+            FrameReader(const char* data, const size_t size) : data_(data), size_(size) {}
+
+            uint32_t u32() {
+                require(4);
+                return EventBatchCodec::get_u32(data_, pos_);
+            }
+
+            uint64_t u64() {
+                require(8);
+                return EventBatchCodec::get_u64(data_, pos_);
+            }
+
+            std::string string() {
+                const uint32_t length = u32();
+                require(length);
+                std::string value(data_ + pos_, length);
+                pos_ += length;
+                return value;
+            }
+
+            void events(std::vector<Event>& out) {
+                pos_ += EventBatchCodec::decode(data_ + pos_, size_ - pos_, out);
+            }
+
+        private:
+            const char* data_;
+            size_t size_;
+            size_t pos_{0};
+
+            void require(const size_t needed) const {
+                if (needed > size_ - pos_) {
+                    throw std::runtime_error("Replication - truncated frame");
+                }
+            }
+        };
+    }
+
+    ReplicationSender::ReplicationSender(EventBus& event_bus, const ReplicationConfig& config)
+        : event_bus_(event_bus), config_(config) {
+        if (config_.max_batch_events == 0) {
+            throw std::runtime_error("Replication - max_batch_events must be at least 1");
+        }
+        if (config_.send_timeout.count() <= 0) {
+            throw std::runtime_error("Replication - send_timeout must be positive");
+        }
+        for (const auto& [topic_name, consumer_groups] : event_bus.consumer_groups_by_topic_name_) {
+            const std::string replication_group_id = EventBus::replication_group_id(topic_name);
+            ReplicatedTopic replicated_topic{&event_bus.topics_.at(topic_name), nullptr, {}, {}};
+            for (const auto& consumer_group : consumer_groups) {
+                if (consumer_group->group_id() == replication_group_id) {
+                    replicated_topic.replication_group = consumer_group.get();
+                } else {
+                    replicated_topic.consumer_groups.push_back(consumer_group.get());
+                }
+            }
+            if (replicated_topic.replication_group != nullptr) {
+                topics_.push_back(std::move(replicated_topic));
+            }
+        }
+        if (topics_.empty()) {
+            throw std::runtime_error("Replication - no topic is configured as replicated");
+        }
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(config_.port);
+        if (inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr) != 1) {
+            throw std::runtime_error("Replication - host " + config_.host + " is not an IPv4 address");
+        }
+        socket_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (socket_fd_ < 0) {
+            throw std::runtime_error(std::string("Replication - socket failed: ") + std::strerror(errno));
+        }
+        if (connect(socket_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            const std::string error = std::strerror(errno);
+            close(socket_fd_);
+            throw std::runtime_error("Replication - cannot connect to standby " + config_.host + ":" +
+                std::to_string(config_.port) + ": " + error);
+        }
+        const int no_delay = 1; // rounds are batched already
+        setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        fcntl(socket_fd_, F_SETFL, fcntl(socket_fd_, F_GETFL) | O_NONBLOCK); // sends are bounded by send_timeout
+        try {
+            event_bus_.attach_replication_sender();
+        } catch (...) {
+            close(socket_fd_);
+            throw;
+        }
+        connected_.store(true, std::memory_order_release);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ReplicationSender::~ReplicationSender() {
+        stopping_.store(true, std::memory_order_release);
+        thread_.join();
+        disconnect();
+        event_bus_.detach_replication_sender();
+    }
+
+    // A round drains up to max_batch_events per lane of every replication group and sends it all with one write.
+    // The round that sees stopping_ still runs, and rounds continue until one finds nothing, so whatever was
+    // published before the destructor started is sent.
+    void ReplicationSender::run() {
+        std::string frames;
+        while (true) {
+            const bool stopping = stopping_.load(std::memory_order_acquire);
+            frames.clear();
+            round_events_ = 0;
+            size_t frame_count = 0;
+            for (auto& replicated_topic : topics_) {
+                frame_count += collect_frames(replicated_topic, frames);
+            }
+            if (!frames.empty()) {
+                send_frames(frames, frame_count);
+            }
+            read_acknowledgements();
+            if (frame_count == 0) {
+                if (stopping) {
+                    break;
+                }
+                std::this_thread::sleep_for(config_.idle_sleep);
+            }
+        }
+    }
+
+    // Cursors go out after the events of the same round and are capped at what was replicated, so the standby
+    // never holds a cursor past its log. A group that consumed events not yet replicated gets them again after a
+    // failover.
+    size_t ReplicationSender::collect_frames(ReplicatedTopic& replicated_topic, std::string& out) {
+        const bool connected = is_connected(); // disconnected rounds only drain
+        const std::string& topic_name = replicated_topic.topic->name();
+        const auto& replication_queues = replicated_topic.replication_group->partition_queues();
+        size_t frame_count = 0;
+        std::vector<std::vector<size_t>> replicated_positions(replication_queues.size());
+        for (size_t partition_index = 0; partition_index < replication_queues.size(); ++partition_index) {
+            const PartitionQueue& partition_queue = *replication_queues[partition_index];
+            replicated_positions[partition_index].resize(partition_queue.lane_count());
+            for (size_t lane_index = 0; lane_index < partition_queue.lane_count(); ++lane_index) {
+                PartitionLane* lane = partition_queue.lane(lane_index);
+                const size_t first_position = lane->consumed_position();
+                batch_.clear();
+                if (lane->dequeue_batch(batch_, config_.max_batch_events, 0) != 0) {
+                    ++frame_count;
+                    round_events_ += batch_.size();
+                    if (connected) {
+                        std::string body;
+                        put_string(body, topic_name);
+                        EventBatchCodec::put_u32(body, static_cast<uint32_t>(partition_index));
+                        EventBatchCodec::put_u32(body, static_cast<uint32_t>(lane_index));
+                        EventBatchCodec::put_u64(body, first_position);
+                        EventBatchCodec::encode(batch_, body, config_.compress);
+                        append_frame(out, FRAME_EVENTS, body);
+                    }
+                }
+                replicated_positions[partition_index][lane_index] = lane->consumed_position();
+            }
+        }
+
+        std::string body;
+        put_string(body, topic_name);
+        EventBatchCodec::put_u64(body, replicated_topic.topic->message_id_watermark());
+        EventBatchCodec::put_u64(body, replicated_topic.topic->sequence_watermark());
+        EventBatchCodec::put_u32(body, static_cast<uint32_t>(replicated_topic.consumer_groups.size()));
+        for (const ConsumerGroup* consumer_group : replicated_topic.consumer_groups) {
+            put_string(body, consumer_group->group_id());
+            const auto& partition_queues = consumer_group->partition_queues();
+            EventBatchCodec::put_u32(body, static_cast<uint32_t>(partition_queues.size()));
+            for (size_t partition_index = 0; partition_index < partition_queues.size(); ++partition_index) {
+                const PartitionQueue& partition_queue = *partition_queues[partition_index];
+                EventBatchCodec::put_u32(body, static_cast<uint32_t>(partition_queue.lane_count()));
+                for (size_t lane_index = 0; lane_index < partition_queue.lane_count(); ++lane_index) {
+                    const PartitionLane* lane = partition_queue.lane(lane_index);
+                    size_t cursor = lane->consumed_position(0);
+                    for (size_t reader = 1; reader < lane->reader_count(); ++reader) {
+                        cursor = std::min(cursor, lane->consumed_position(reader)); // slowest consumer of a broadcast group
+                    }
+                    const bool replicated = partition_index < replicated_positions.size() &&
+                        lane_index < replicated_positions[partition_index].size();
+                    cursor = std::min(cursor, replicated ? replicated_positions[partition_index][lane_index] : 0);
+                    EventBatchCodec::put_u64(body, cursor);
+                }
+            }
+        }
+        if (body != replicated_topic.last_cursors) {
+            ++frame_count;
+            if (connected) {
+                append_frame(out, FRAME_CURSORS, body);
+            }
+            replicated_topic.last_cursors = std::move(body);
+        }
+        return frame_count;
+    }
+
+    void ReplicationSender::send_frames(const std::string& frames, const size_t frame_count) {
+        if (!is_connected()) {
+            return;
+        }
+        if (!send_all(socket_fd_, frames.data(), frames.size(), config_.send_timeout)) {
+            disconnect();
+            return;
+        }
+        sent_events_.fetch_add(round_events_, std::memory_order_release);
+        sent_frames_.fetch_add(frame_count, std::memory_order_release);
+    }
+
+    void ReplicationSender::read_acknowledgements() {
+        if (!is_connected()) {
+            return;
+        }
+        char chunk[256];
+        while (true) {
+            const ssize_t received = recv(socket_fd_, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (received > 0) {
+                acknowledgement_buffer_.append(chunk, static_cast<size_t>(received));
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                disconnect(); // standby closed the connection or it broke
+                return;
+            }
+            if (errno != EINTR) {
+                break;
+            }
+        }
+        // Acknowledgements are cumulative, only the last complete one matters
+        const size_t complete = acknowledgement_buffer_.size() / 8 * 8;
+        if (complete != 0) {
+            size_t pos = complete - 8;
+            acknowledged_frames_.store(EventBatchCodec::get_u64(acknowledgement_buffer_.data(), pos), std::memory_order_release);
+            acknowledgement_buffer_.erase(0, complete);
+        }
+    }
+
+    void ReplicationSender::disconnect() {
+        connected_.store(false, std::memory_order_release);
+        if (socket_fd_ >= 0) {
+            close(socket_fd_);
+            socket_fd_ = -1;
+        }
+    }
+
+    StandbyReplica::StandbyReplica(const StandbyConfig& config) : config_(config) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error(std::string("Standby replica - socket failed: ") + std::strerror(errno));
+        }
+        const int reuse = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(config_.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t address_size = sizeof(address);
+        if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listen_fd_, 1) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &address_size) != 0) {
+            const std::string error = std::strerror(errno);
+            close(listen_fd_);
+            throw std::runtime_error("Standby replica - cannot listen on port " + std::to_string(config_.port) + ": " + error);
+        }
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    StandbyReplica::~StandbyReplica() {
+        stop();
+    }
+
+    // Serves one primary. Once it disconnects, or sends something that does not parse, the replica keeps what it
+    // has applied so far and waits for take_over().
+    void StandbyReplica::run() {
+        pollfd listening{listen_fd_, POLLIN, 0};
+        while (connection_fd_ < 0) {
+            if (stopping_.load(std::memory_order_acquire)) {
+                return;
+            }
+            if (poll(&listening, 1, POLL_INTERVAL_MS) > 0) {
+                connection_fd_ = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            }
+        }
+        connected_.store(true, std::memory_order_release);
+
+        std::string buffer;
+        std::vector<char> chunk(1 << 16);
+        pollfd connection{connection_fd_, POLLIN, 0};
+        while (!stopping_.load(std::memory_order_acquire)) {
+            if (poll(&connection, 1, POLL_INTERVAL_MS) <= 0) {
+                continue;
+            }
+            const ssize_t received = recv(connection_fd_, chunk.data(), chunk.size(), 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                break;
+            }
+            buffer.append(chunk.data(), static_cast<size_t>(received));
+            try {
+                apply_frames(buffer);
+            } catch (const std::exception&) {
+                break; // a corrupt stream would only corrupt the log further
+            }
+            std::string acknowledgement;
+            EventBatchCodec::put_u64(acknowledgement, applied_frames());
+            send(connection_fd_, acknowledgement.data(), acknowledgement.size(), MSG_NOSIGNAL | MSG_DONTWAIT); // a later one will do
+        }
+        connected_.store(false, std::memory_order_release);
+        close(connection_fd_);
+        connection_fd_ = -1;
+    }
+
+    void StandbyReplica::apply_frames(std::string& buffer) {
+        size_t pos = 0;
+        while (buffer.size() - pos >= FRAME_HEADER_SIZE) {
+            size_t body_pos = pos;
+            const uint32_t body_size = EventBatchCodec::get_u32(buffer.data(), body_pos);
+            const uint8_t type = static_cast<uint8_t>(buffer[body_pos++]);
+            if (buffer.size() - body_pos < body_size) {
+                break; // rest of the frame still on its way
+            }
+            switch (type) {
+                case FRAME_EVENTS:
+                    apply_events(buffer.data() + body_pos, body_size);
+                    break;
+                case FRAME_CURSORS:
+                    apply_cursors(buffer.data() + body_pos, body_size);
+                    break;
+                default:
+                    throw std::runtime_error("Replication - unknown frame type " + std::to_string(type));
+            }
+            pos = body_pos + body_size;
+            applied_frames_.fetch_add(1, std::memory_order_release);
+        }
+        buffer.erase(0, pos);
+    }
+
+    void StandbyReplica::apply_events(const char* body, const size_t size) {
+        FrameReader reader(body, size);
+        const std::string topic_name = reader.string();
+        const uint32_t partition_index = reader.u32();
+        const uint32_t lane_index = reader.u32();
+        const uint64_t first_position = reader.u64();
+        std::vector<Event> events;
+        reader.events(events);
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        TopicLog& topic_log = topics_[topic_name];
+        if (topic_log.partitions.size() <= partition_index) {
+            topic_log.partitions.resize(partition_index + 1);
+        }
+        auto& lanes = topic_log.partitions[partition_index];
+        if (lanes.size() <= lane_index) {
+            lanes.resize(lane_index + 1);
+        }
+        LaneLog& lane_log = lanes[lane_index];
+        if (lane_log.events.empty()) {
+            lane_log.base_position = first_position;
+        } else if (lane_log.base_position + lane_log.events.size() != first_position) {
+            throw std::runtime_error("Replication - events of topic " + topic_name + " partition " +
+                std::to_string(partition_index) + " do not continue the lane");
+        }
+        for (auto& event : events) {
+            lane_log.events.push_back(std::move(event));
+        }
+    }
+
+    void StandbyReplica::apply_cursors(const char* body, const size_t size) {
+        FrameReader reader(body, size);
+        const std::string topic_name = reader.string();
+        const uint64_t next_message_id = reader.u64();
+        const uint64_t next_sequence = reader.u64();
+        const uint32_t group_count = reader.u32();
+        std::unordered_map<std::string, LaneCursors> group_cursors;
+        for (uint32_t i = 0; i < group_count; ++i) {
+            LaneCursors& cursors = group_cursors[reader.string()];
+            cursors.resize(reader.u32());
+            for (auto& lane_cursors : cursors) {
+                lane_cursors.resize(reader.u32());
+                for (auto& cursor : lane_cursors) {
+                    cursor = reader.u64();
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        TopicLog& topic_log = topics_[topic_name];
+        topic_log.next_message_id = std::max<size_t>(topic_log.next_message_id, next_message_id);
+        topic_log.next_sequence = std::max<size_t>(topic_log.next_sequence, next_sequence);
+        topic_log.group_cursors = std::move(group_cursors);
+        trim(topic_log);
+    }
+
+    // With state_mutex_ held. A topic nobody but the replication group reads keeps nothing.
+    void StandbyReplica::trim(TopicLog& topic_log) const {
+        for (size_t partition_index = 0; partition_index < topic_log.partitions.size(); ++partition_index) {
+            auto& lanes = topic_log.partitions[partition_index];
+            for (size_t lane_index = 0; lane_index < lanes.size(); ++lane_index) {
+                LaneLog& lane_log = lanes[lane_index];
+                size_t keep_from = lane_log.base_position + lane_log.events.size();
+                for (const auto& [group_id, cursors] : topic_log.group_cursors) {
+                    const bool known = partition_index < cursors.size() && lane_index < cursors[partition_index].size();
+                    keep_from = std::min(keep_from, known ? cursors[partition_index][lane_index] : 0);
+                }
+                while (lane_log.base_position < keep_from && !lane_log.events.empty()) {
+                    lane_log.events.pop_front();
+                    ++lane_log.base_position;
+                }
+            }
+        }
+    }
+
+    // Replication groups resume at the end of their lanes, so a standby of this bus lines up with the other groups
+    void StandbyReplica::take_over(EventBus& event_bus) {
+        stop();
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        BusSnapshot snapshot;
+        for (const auto& [topic_name, topic_log] : topics_) {
+            snapshot.topics.push_back({topic_name, topic_log.next_message_id, topic_log.next_sequence});
+            const LaneCursors* layout = nullptr; // partitions and lanes of the topic's groups
+            LaneCursors replication_cursors;
+            for (const auto& [group_id, cursors] : topic_log.group_cursors) {
+                ConsumerGroupSnapshot group{group_id, topic_name, {}};
+                group.partitions.resize(cursors.size());
+                for (size_t partition_index = 0; partition_index < cursors.size(); ++partition_index) {
+                    auto& lanes = group.partitions[partition_index].lanes;
+                    lanes.resize(cursors[partition_index].size());
+                    for (size_t lane_index = 0; lane_index < lanes.size(); ++lane_index) {
+                        const size_t cursor = cursors[partition_index][lane_index];
+                        LaneSnapshot& lane = lanes[lane_index];
+                        lane.cursor = cursor;
+                        if (partition_index >= topic_log.partitions.size() ||
+                            lane_index >= topic_log.partitions[partition_index].size()) {
+                            continue; // nothing was ever replicated from this lane
+                        }
+                        const LaneLog& lane_log = topic_log.partitions[partition_index][lane_index];
+                        const size_t end = lane_log.base_position + lane_log.events.size();
+                        lane.cursor = std::clamp(cursor, lane_log.base_position, std::max(end, lane_log.base_position));
+                        lane.pending_events.assign(lane_log.events.begin() + static_cast<std::ptrdiff_t>(
+                            lane.cursor - lane_log.base_position), lane_log.events.end());
+                    }
+                }
+                snapshot.consumer_groups.push_back(std::move(group));
+                layout = &cursors;
+            }
+
+            const std::string replication_group_id = EventBus::replication_group_id(topic_name);
+            if (layout == nullptr || event_bus.topic_name_by_consumer_group_id_.count(replication_group_id) == 0) {
+                continue;
+            }
+            ConsumerGroupSnapshot replication_group{replication_group_id, topic_name, {}};
+            replication_group.partitions.resize(layout->size());
+            for (size_t partition_index = 0; partition_index < layout->size(); ++partition_index) {
+                auto& lanes = replication_group.partitions[partition_index].lanes;
+                lanes.resize((*layout)[partition_index].size());
+                for (size_t lane_index = 0; lane_index < lanes.size(); ++lane_index) {
+                    size_t end = 0;
+                    if (partition_index < topic_log.partitions.size() && lane_index < topic_log.partitions[partition_index].size()) {
+                        const LaneLog& lane_log = topic_log.partitions[partition_index][lane_index];
+                        end = lane_log.base_position + lane_log.events.size();
+                    }
+                    for (const auto& [group_id, cursors] : topic_log.group_cursors) {
+                        if (partition_index < cursors.size() && lane_index < cursors[partition_index].size()) {
+                            end = std::max(end, cursors[partition_index][lane_index]);
+                        }
+                    }
+                    lanes[lane_index].cursor = end;
+                }
+            }
+            snapshot.consumer_groups.push_back(std::move(replication_group));
+        }
+        event_bus.restore_snapshot(snapshot);
+    }
+
+    void StandbyReplica::stop() {
+        stopping_.store(true, std::memory_order_release);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+        }
+    }
+}
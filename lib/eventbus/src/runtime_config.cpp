@@ -0,0 +1,107 @@
+#include "runtime_config.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace eventbus {
+    namespace {
+        std::string trim(const std::string& value) {
+            const size_t begin = value.find_first_not_of(" \t\r");
+            if (begin == std::string::npos) {
+                return "";
+            }
+            const size_t end = value.find_last_not_of(" \t\r");
+            return value.substr(begin, end - begin + 1);
+        }
+
+        long long parse_number(const std::string& value, const size_t line_number) {
+            size_t parsed = 0;
+            long long number = 0;
+            try {
+                number = std::stoll(value, &parsed);
+            } catch (const std::exception&) {
+                parsed = 0;
+            }
+            if (parsed != value.size() || number < 0) {
+                throw std::runtime_error("Runtime config line " + std::to_string(line_number) + " - invalid number: " + value);
+            }
+            return number;
+        }
+
+        BackPressureStrategy parse_strategy(const std::string& value, const size_t line_number) {
+            if (value == "DROP_NEWEST") return BackPressureStrategy::DROP_NEWEST;
+            if (value == "BLOCK") return BackPressureStrategy::BLOCK;
+            if (value == "SPIN") return BackPressureStrategy::SPIN;
+            if (value == "YIELDING_SPIN") return BackPressureStrategy::YIELDING_SPIN;
+            throw std::runtime_error("Runtime config line " + std::to_string(line_number) + " - unknown back-pressure strategy: " + value);
+        }
+
+        // Splits "<prefix>.<name>.<setting>" where the name itself may contain dots
+        bool split_scoped_key(const std::string& key, const std::string& prefix, std::string& name, std::string& setting) {
+            if (key.compare(0, prefix.size() + 1, prefix + ".") != 0) {
+                return false;
+            }
+            const size_t last_dot = key.rfind('.');
+            if (last_dot <= prefix.size()) {
+                return false;
+            }
+            name = key.substr(prefix.size() + 1, last_dot - prefix.size() - 1);
+            setting = key.substr(last_dot + 1);
+            return !name.empty();
+        }
+    }
+
+    RuntimeConfigUpdate parse_runtime_config(const std::string& text) {
+        RuntimeConfigUpdate update;
+        std::istringstream input(text);
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(input, line)) {
+            ++line_number;
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+            line = trim(line);
+            if (line.empty()) {
+                continue;
+            }
+            const size_t equals = line.find('=');
+            if (equals == std::string::npos) {
+                throw std::runtime_error("Runtime config line " + std::to_string(line_number) + " - expected key = value");
+            }
+            const std::string key = trim(line.substr(0, equals));
+            const std::string value = trim(line.substr(equals + 1));
+
+            std::string name;
+            std::string setting;
+            if (key == "backpressure.strategy") {
+                update.back_pressure_strategy = parse_strategy(value, line_number);
+            } else if (key == "backpressure.spin_yield_threshold") {
+                update.spin_yield_threshold = static_cast<int>(parse_number(value, line_number));
+            } else if (key == "backpressure.block_sleep_us") {
+                update.block_sleep_duration = std::chrono::microseconds(parse_number(value, line_number));
+            } else if (key == "backpressure.timeout_ms") {
+                update.timeout = std::chrono::milliseconds(parse_number(value, line_number));
+            } else if (split_scoped_key(key, "topic", name, setting) && setting == "queue_capacity") {
+                update.queue_capacity_by_topic[name] = static_cast<size_t>(parse_number(value, line_number));
+            } else if (split_scoped_key(key, "group", name, setting) && setting == "queue_capacity") {
+                update.queue_capacity_by_group[name] = static_cast<size_t>(parse_number(value, line_number));
+            } else {
+                throw std::runtime_error("Runtime config line " + std::to_string(line_number) + " - unknown key: " + key);
+            }
+        }
+        return update;
+    }
+
+    RuntimeConfigUpdate parse_runtime_config_file(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open runtime config file - " + path);
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        return parse_runtime_config(content.str());
+    }
+}
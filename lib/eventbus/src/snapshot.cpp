@@ -0,0 +1,155 @@
+#include "snapshot.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "event_codec.hpp"
+
+namespace eventbus {
+    namespace {
+        constexpr uint32_t SNAPSHOT_MAGIC = 0x53425645; // "EVBS"
+        constexpr uint32_t SNAPSHOT_VERSION = 3;
+        constexpr uint32_t SNAPSHOT_VERSION_WITHOUT_SEQUENCES = 2; // still read, topics restart their sequence at 1
+
+        void put_string(std::string& out, const std::string& value) {
+            EventBatchCodec::put_u32(out, static_cast<uint32_t>(value.size()));
+            out.append(value);
+        }
+
+        class SnapshotReader {
+        public:
+            explicit SnapshotReader(const std::string& data) : data_(data) {}
+
+            uint32_t u32() {
+                require(4);
+                return EventBatchCodec::get_u32(data_.data(), pos_);
+            }
+
+            uint64_t u64() {
+                require(8);
+                return EventBatchCodec::get_u64(data_.data(), pos_);
+            }
+
+            std::string string() {
+                const uint32_t length = u32();
+                require(length);
+                std::string value = data_.substr(pos_, length);
+                pos_ += length;
+                return value;
+            }
+
+            void events(std::vector<Event>& out) {
+                pos_ += EventBatchCodec::decode(data_.data() + pos_, data_.size() - pos_, out);
+            }
+
+        private:
+            const std::string& data_;
+            size_t pos_{0};
+
+            void require(const size_t needed) const {
+                if (needed > data_.size() - pos_) {
+                    throw std::runtime_error("Truncated snapshot file");
+                }
+            }
+        };
+    }
+
+    void write_snapshot_file(const BusSnapshot& snapshot, const std::string& path) {
+        std::string out;
+        EventBatchCodec::put_u32(out, SNAPSHOT_MAGIC);
+        EventBatchCodec::put_u32(out, SNAPSHOT_VERSION);
+
+        EventBatchCodec::put_u32(out, static_cast<uint32_t>(snapshot.topics.size()));
+        for (const auto& topic : snapshot.topics) {
+            put_string(out, topic.name);
+            EventBatchCodec::put_u64(out, topic.next_message_id);
+            EventBatchCodec::put_u64(out, topic.next_sequence);
+        }
+
+        EventBatchCodec::put_u32(out, static_cast<uint32_t>(snapshot.consumer_groups.size()));
+        for (const auto& group : snapshot.consumer_groups) {
+            put_string(out, group.group_id);
+            put_string(out, group.topic_name);
+            EventBatchCodec::put_u32(out, static_cast<uint32_t>(group.partitions.size()));
+            for (const auto& partition : group.partitions) {
+                EventBatchCodec::put_u32(out, static_cast<uint32_t>(partition.lanes.size()));
+                for (const auto& lane : partition.lanes) {
+                    EventBatchCodec::put_u64(out, lane.cursor);
+                    EventBatchCodec::encode(lane.pending_events, out);
+                }
+            }
+        }
+
+        // write to a temp file and rename so a crash mid-write never leaves a torn snapshot behind
+        const std::string tmp_path = path + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                throw std::runtime_error("Cannot open snapshot file - " + tmp_path);
+            }
+            file.write(out.data(), static_cast<std::streamsize>(out.size()));
+            if (!file) {
+                throw std::runtime_error("Failed writing snapshot file - " + tmp_path);
+            }
+        }
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Cannot move snapshot file into place - " + path);
+        }
+    }
+
+    BusSnapshot read_snapshot_file(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Cannot open snapshot file - " + path);
+        }
+        std::string data(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("Failed reading snapshot file - " + path);
+        }
+
+        SnapshotReader reader(data);
+        if (reader.u32() != SNAPSHOT_MAGIC) {
+            throw std::runtime_error("Not a snapshot file - " + path);
+        }
+        const uint32_t version = reader.u32();
+        if (version != SNAPSHOT_VERSION && version != SNAPSHOT_VERSION_WITHOUT_SEQUENCES) {
+            throw std::runtime_error("Unsupported snapshot version - " + path);
+        }
+
+        BusSnapshot snapshot;
+        const uint32_t topic_count = reader.u32();
+        for (uint32_t i = 0; i < topic_count; ++i) {
+            TopicSnapshot topic;
+            topic.name = reader.string();
+            topic.next_message_id = reader.u64();
+            if (version != SNAPSHOT_VERSION_WITHOUT_SEQUENCES) {
+                topic.next_sequence = reader.u64();
+            }
+            snapshot.topics.push_back(std::move(topic));
+        }
+
+        const uint32_t group_count = reader.u32();
+        for (uint32_t i = 0; i < group_count; ++i) {
+            ConsumerGroupSnapshot group;
+            group.group_id = reader.string();
+            group.topic_name = reader.string();
+            const uint32_t partition_count = reader.u32();
+            for (uint32_t p = 0; p < partition_count; ++p) {
+                PartitionSnapshot partition;
+                const uint32_t lane_count = reader.u32();
+                for (uint32_t l = 0; l < lane_count; ++l) {
+                    LaneSnapshot lane;
+                    lane.cursor = reader.u64();
+                    reader.events(lane.pending_events);
+                    partition.lanes.push_back(std::move(lane));
+                }
+                group.partitions.push_back(std::move(partition));
+            }
+            snapshot.consumer_groups.push_back(std::move(group));
+        }
+        return snapshot;
+    }
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include <array>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "event_bus.hpp"
+
+namespace eventbus {
+    // Defaults a topic description inherits, shadow any of them in the description
+    struct StaticTopicDefaults {
+        static constexpr size_t queue_capacity = 16384;
+        static constexpr size_t memory_budget_bytes = 0;
+        static constexpr QueueEngine queue_engine = QueueEngine::CAS_RING;
+        static constexpr size_t initial_queue_capacity = 0;
+        static constexpr bool allocate_queues_on_first_use = false;
+        static constexpr KeylessPartitioning keyless_partitioning = KeylessPartitioning::ROUND_ROBIN;
+        static constexpr std::string_view partition_key_field = "";
+        static constexpr bool total_order = false;
+        static constexpr bool replicated = false;
+        using consumer_groups = std::tuple<>;
+    };
+
+    // Same for a consumer group description
+    struct StaticConsumerGroupDefaults {
+        static constexpr size_t consumer_count = 1;
+        static constexpr std::string_view tenant = "";
+        static constexpr bool broadcast = false;
+        static constexpr bool acknowledged = false;
+    };
+
+    template<typename TopicSpec>
+    constexpr bool is_valid_static_topic() {
+        return !TopicSpec::name.empty() && TopicSpec::partition_count != 0 &&
+            TopicSpec::queue_capacity >= EventRing::MIN_CAPACITY &&
+            (TopicSpec::queue_capacity & (TopicSpec::queue_capacity - 1)) == 0;
+    }
+
+    template<typename... TopicSpecs>
+    constexpr bool has_unique_static_topic_names() {
+        constexpr std::array<std::string_view, sizeof...(TopicSpecs)> names{TopicSpecs::name...};
+        for (size_t i = 0; i < names.size(); ++i) {
+            for (size_t j = i + 1; j < names.size(); ++j) {
+                if (names[i] == names[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // A topology known at build time, one description type per topic:
+    //
+    //   struct Pricers : StaticConsumerGroupDefaults {
+    //       static constexpr std::string_view group_id = "pricers";
+    //       static constexpr size_t consumer_count = 4;
+    //   };
+    //   struct Quotes : StaticTopicDefaults {
+    //       static constexpr std::string_view name = "quotes";
+    //       static constexpr size_t partition_count = 8;
+    //       using consumer_groups = std::tuple<Pricers>;
+    //   };
+    //   using MarketData = StaticTopology<Quotes, Trades>;
+    //
+    // Topic descriptions are checked at compile time. Their partition counts are compiled into the publishers of
+    // a StaticEventBus, so these topics can never be repartitioned.
+    template<typename... TopicSpecs>
+    class StaticTopology {
+        static_assert(sizeof...(TopicSpecs) != 0, "A static topology needs at least one topic");
+        static_assert((is_valid_static_topic<TopicSpecs>() && ...),
+            "Static topics need a name, at least one partition and a power of two queue capacity of at least 2");
+        static_assert(has_unique_static_topic_names<TopicSpecs...>(), "Static topic names must be unique");
+
+    public:
+        static constexpr size_t topic_count = sizeof...(TopicSpecs);
+
+        template<typename TopicSpec>
+        static constexpr bool contains() {
+            return (std::is_same_v<TopicSpec, TopicSpecs> || ...);
+        }
+
+        template<typename TopicSpec>
+        static constexpr size_t index_of() {
+            static_assert(contains<TopicSpec>(), "Topic is not part of this static topology");
+            constexpr std::array<bool, topic_count> matches{std::is_same_v<TopicSpec, TopicSpecs>...};
+            size_t index = 0;
+            while (index < topic_count && !matches[index]) {
+                ++index;
+            }
+            return index;
+        }
+
+        static constexpr std::array<std::string_view, topic_count> topic_names() {
+            return {TopicSpecs::name...};
+        }
+
+        // Adds the topics and their consumer groups to a config that may hold tenants, budgets or more topics
+        static void append_to(EventBusConfig& config) {
+            (append_topic<TopicSpecs>(config), ...);
+        }
+
+    private:
+        template<typename TopicSpec>
+        static void append_topic(EventBusConfig& config) {
+            TopicConfig topic_config{std::string(TopicSpec::name), TopicSpec::partition_count, TopicSpec::queue_capacity,
+                TopicSpec::memory_budget_bytes, TopicSpec::queue_engine};
+            topic_config.initial_queue_capacity = TopicSpec::initial_queue_capacity;
+            topic_config.allocate_queues_on_first_use = TopicSpec::allocate_queues_on_first_use;
+            topic_config.static_partition_count = true;
+            topic_config.keyless_partitioning = TopicSpec::keyless_partitioning;
+            topic_config.partition_key_field = std::string(TopicSpec::partition_key_field);
+            topic_config.total_order = TopicSpec::total_order;
+            topic_config.replicated = TopicSpec::replicated;
+            config.topics.push_back(std::move(topic_config));
+            append_consumer_groups<TopicSpec>(config, static_cast<typename TopicSpec::consumer_groups*>(nullptr));
+        }
+
+        template<typename TopicSpec, typename... GroupSpecs>
+        static void append_consumer_groups(EventBusConfig& config, std::tuple<GroupSpecs...>*) {
+            (config.consumer_groups.push_back({std::string(GroupSpecs::group_id), std::string(TopicSpec::name),
+                GroupSpecs::consumer_count, std::string(GroupSpecs::tenant), GroupSpecs::broadcast,
+                GroupSpecs::acknowledged}), ...);
+        }
+    };
+
+    // EventBus built from a StaticTopology. publish<Topic>() saves the hash map lookup of the topic name, the
+    // topic sits in an array slot picked at compile time, and round robin routing divides by a constant. That is
+    // all that is static: keys are hashed and the route table is read at run time, and from there on it is the
+    // regular publish path, so back-pressure, tenants and budgets behave exactly as with EventBus::publish_event.
+    // Everything else (consumers, snapshots, reloads) goes through event_bus().
+    template<typename Topology>
+    class StaticEventBus {
+    public:
+        // config may carry tenants, budgets and topics of its own, the static topology is added to it
+        explicit StaticEventBus(EventBusConfig config = {}, const BackPressureConfig& back_pressure_config = {}) :
+        event_bus_(with_topology(std::move(config)), back_pressure_config) {
+            const auto topic_names = Topology::topic_names();
+            for (size_t i = 0; i < Topology::topic_count; ++i) {
+                topics_[i] = &event_bus_.topics_.at(std::string(topic_names[i]));
+            }
+        }
+
+        StaticEventBus(const StaticEventBus&) = delete;
+        StaticEventBus& operator=(const StaticEventBus&) = delete;
+
+        // event.topic is not looked at, it should still name the topic for the consumers
+        template<typename TopicSpec>
+        bool publish(const Event& event, const std::string& partition_key = "") {
+            constexpr size_t topic_index = Topology::template index_of<TopicSpec>();
+            return event_bus_.template publish_to_topic<TopicSpec::partition_count>(*topics_[topic_index], event,
+                partition_key, 0);
+        }
+
+        // Publishes on behalf of a tenant, see EventBus::publish_event(TenantTag, ...)
+        template<typename TopicSpec>
+        bool publish(const TenantTag tenant_tag, const Event& event, const std::string& partition_key = "") {
+            constexpr size_t topic_index = Topology::template index_of<TopicSpec>();
+            Tenant& tenant = *event_bus_.tenants_[tenant_tag.index];
+            if (!tenant.try_acquire_publish()) {
+                return false; // over quota, dropped like a full queue
+            }
+            return event_bus_.template publish_to_topic<TopicSpec::partition_count>(*topics_[topic_index], event,
+                partition_key, tenant.lane_index());
+        }
+
+        template<typename GroupSpec>
+        [[nodiscard]] const std::vector<std::unique_ptr<Consumer>>& consumers() const {
+            return event_bus_.consumers_by_consumer_group_id().at(std::string(GroupSpec::group_id));
+        }
+
+        [[nodiscard]] EventBus& event_bus() {
+            return event_bus_;
+        }
+
+        [[nodiscard]] const EventBus& event_bus() const {
+            return event_bus_;
+        }
+
+    private:
+        static EventBusConfig with_topology(EventBusConfig config) {
+            Topology::append_to(config);
+            return config;
+        }
+
+        EventBus event_bus_;
+        std::array<Topic*, Topology::topic_count> topics_{};
+    };
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace eventbus {
+    // Handle a producer keeps to publish on behalf of a tenant, obtained once from EventBus::tenant_tag
+    struct TenantTag {
+        size_t index;
+    };
+
+    class Tenant {
+    public:
+        Tenant(std::string name, const uint32_t max_publish_events_per_window,
+            const std::chrono::nanoseconds publish_quota_window, const size_t isolated_queue_capacity,
+            const size_t memory_budget_bytes):
+        name_(std::move(name)),
+        max_publish_events_per_window_(max_publish_events_per_window),
+        publish_quota_window_ns_(std::max<int64_t>(publish_quota_window.count(), 1)),
+        isolated_queue_capacity_(isolated_queue_capacity),
+        memory_budget_bytes_(memory_budget_bytes) {}
+
+        // Fixed window quota kept in one atomic word: high 32 bits window number, low 32 bits events admitted.
+        // The common case is a single fetch_add, only the first publisher of a new window has to CAS.
+        bool try_acquire_publish() {
+            if (max_publish_events_per_window_ == 0) {
+                return true;
+            }
+            const auto window = static_cast<uint32_t>(
+                std::chrono::steady_clock::now().time_since_epoch().count() / publish_quota_window_ns_);
+            uint64_t state = quota_state_.load(std::memory_order_relaxed);
+            while (true) {
+                if (static_cast<int32_t>(window - static_cast<uint32_t>(state >> 32)) > 0) {
+                    // Stale window, try to start the new one with ourselves counted
+                    if (quota_state_.compare_exchange_weak(state, (static_cast<uint64_t>(window) << 32) | 1,
+                                                           std::memory_order_relaxed)) {
+                        return true;
+                    }
+                    continue;
+                }
+                state = quota_state_.fetch_add(1, std::memory_order_relaxed);
+                if (static_cast<int32_t>(window - static_cast<uint32_t>(state >> 32)) > 0) {
+                    continue; // window rolled over under us, our increment landed in the stale window
+                }
+                return static_cast<uint32_t>(state) < max_publish_events_per_window_;
+            }
+        }
+
+        [[nodiscard]] const std::string& name() const {
+            return name_;
+        }
+
+        [[nodiscard]] size_t isolated_queue_capacity() const {
+            return isolated_queue_capacity_;
+        }
+
+        [[nodiscard]] size_t memory_budget_bytes() const {
+            return memory_budget_bytes_;
+        }
+
+        // Lane of this tenant in the publish routes, 0 is the shared lane. Topics outside its isolated topics route
+        // it to the shared lane too.
+        [[nodiscard]] size_t lane_index() const {
+            return lane_index_;
+        }
+
+        void set_lane_index(const size_t lane_index) {
+            lane_index_ = lane_index;
+        }
+
+    private:
+        std::string name_;
+        uint32_t max_publish_events_per_window_;
+        int64_t publish_quota_window_ns_;
+        size_t isolated_queue_capacity_;
+        size_t memory_budget_bytes_;
+        size_t lane_index_{0};
+        alignas(64) std::atomic<uint64_t> quota_state_{0};
+    };
+}
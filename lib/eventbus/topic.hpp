@@ -1,26 +1,210 @@
 #pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#include "event_bus_config.hpp"
+#include "event_ring.hpp"
+#include "grace_period.hpp"
+#include "json_key_scanner.hpp"
+#include "partition_queue.hpp"
+#include "rcu_ptr.hpp"
 
 namespace eventbus {
+    // Everything a publish needs to reach the lanes of a topic, flattened into one array indexed
+    // [partition][lane][group]: the lanes of every group for one event sit next to each other, so the fan out reads
+    // a cache line or two of plain pointers instead of walking group -> partition queue -> lane per group.
+    // The lanes are owned by the partition queues of the groups and live as long as the bus.
+    struct TopicRoutes {
+        size_t lane_count = 0;
+        size_t group_count = 0;
+        std::vector<PartitionLane*> lanes;
+        std::vector<std::mutex*> fan_out_locks; // [partition][lane], replicated topics only
+
+        [[nodiscard]] PartitionLane* const* group_lanes(const size_t partition_index, const size_t lane_index) const {
+            return lanes.data() + (partition_index * lane_count + lane_index) * group_count;
+        }
+
+        // Held while one event or batch fans out to the groups, so every group's lane gets them in the same order.
+        // Not locked at all on topics that are not replicated.
+        [[nodiscard]] std::unique_lock<std::mutex> lock_fan_out(const size_t partition_index, const size_t lane_index) const {
+            if (fan_out_locks.empty()) {
+                return {};
+            }
+            return std::unique_lock<std::mutex>(*fan_out_locks[partition_index * lane_count + lane_index]);
+        }
+    };
+
     class Topic {
     public:
-        explicit Topic(std::string name, const size_t partition_count):
+        explicit Topic(std::string name, const size_t partition_count, const size_t queue_capacity = 16384,
+            const size_t memory_budget_bytes = 0, const QueueEngine queue_engine = QueueEngine::CAS_RING,
+            const RingAllocation& ring_allocation = {}, const bool static_partition_count = false,
+            const KeylessPartitioning keyless_partitioning = KeylessPartitioning::ROUND_ROBIN,
+            const std::string& partition_key_field = "", const bool total_order = false, const bool replicated = false):
         name_(std::move(name)),
-        partition_count_(partition_count){}
+        partition_count_(partition_count),
+        queue_capacity_(queue_capacity),
+        memory_budget_bytes_(memory_budget_bytes),
+        queue_engine_(queue_engine),
+        ring_allocation_(ring_allocation),
+        static_partition_count_(static_partition_count),
+        keyless_partitioning_(keyless_partitioning),
+        total_order_(total_order),
+        replicated_(replicated),
+        routes_(std::make_unique<TopicRoutes>()) {
+            if (!partition_key_field.empty()) {
+                partition_key_scanner_.emplace(partition_key_field);
+            }
+            ring_allocation_.producer_grace_period = &routing_grace_period_; // publishers enqueue inside its guards
+        }
 
+        Topic(const Topic&) = delete;
+        Topic& operator=(const Topic&) = delete;
 
-        [[nodiscard]] const std::string& name() {
+        [[nodiscard]] const std::string& name() const {
             return name_;
         }
 
+        // Publishers read this inside a routing_grace_period() read guard, so a repartition can tell when nobody
+        // routes with the old count anymore
         [[nodiscard]] size_t partition_count() const {
-            return partition_count_;
+            return partition_count_.load(std::memory_order_acquire);
+        }
+
+        void set_partition_count(const size_t partition_count) {
+            partition_count_.store(partition_count, std::memory_order_release);
+        }
+
+        // Publishers of a StaticTopology route with the partition count as a compile time constant
+        [[nodiscard]] bool has_static_partition_count() const {
+            return static_partition_count_;
+        }
+
+        [[nodiscard]] KeylessPartitioning keyless_partitioning() const {
+            return keyless_partitioning_;
+        }
+
+        // The configured payload field of an event published without a key. Viewing into payload, false when the
+        // topic extracts no keys or the field is not there.
+        bool extract_partition_key(const std::string_view payload, std::string_view& key) const {
+            return partition_key_scanner_ && partition_key_scanner_->extract(payload, key);
+        }
+
+        [[nodiscard]] GracePeriod& routing_grace_period() {
+            return routing_grace_period_;
+        }
+
+        // Read by publishers inside a routing_grace_period() read guard. A table always covers at least the
+        // partition count published next to it, the bus swaps in the bigger table before raising the count.
+        [[nodiscard]] const TopicRoutes& routes() const {
+            return *routes_.load();
+        }
+
+        void set_routes(std::unique_ptr<TopicRoutes> routes) {
+            routes_.update(std::move(routes));
+        }
+
+        size_t next_message_id() {
+            return next_message_id_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Id the next published event gets, snapshots carry it over
+        [[nodiscard]] size_t message_id_watermark() const {
+            return next_message_id_.load(std::memory_order_acquire);
+        }
+
+        void advance_message_id_watermark(const size_t next_message_id) {
+            size_t current = next_message_id_.load(std::memory_order_relaxed);
+            while (current < next_message_id &&
+                !next_message_id_.compare_exchange_weak(current, next_message_id, std::memory_order_release)) {
+            }
+        }
+
+        // Mirrored to a standby, see TopicConfig::replicated
+        [[nodiscard]] bool replicated() const {
+            return replicated_;
+        }
+
+        // Control plane only, for the route tables of a replicated topic: the fan out lock of one lane of one
+        // partition queue, indexed [partition][queue lane]. Locks are created on first request and never move.
+        std::mutex* fan_out_lock(const size_t index) {
+            while (fan_out_locks_.size() <= index) {
+                fan_out_locks_.emplace_back();
+            }
+            return &fan_out_locks_[index];
+        }
+
+        // Whether publishes stamp Event::sequence, the order merge consumers restore across partitions
+        [[nodiscard]] bool total_order() const {
+            return total_order_;
+        }
+
+        // First of count consecutive sequences. One call per event for single publishes, one per flush for a
+        // Publisher. Sequences start at 1, Event::NO_SEQUENCE is never handed out. Only the Publisher amortizes
+        // the shared counter: a sequence block handed to one thread ahead of time would order its events by when
+        // the block was taken instead of when they were published.
+        size_t reserve_sequences(const size_t count) {
+            return next_sequence_.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Sequence the next reservation starts at, snapshots carry it over
+        [[nodiscard]] size_t sequence_watermark() const {
+            return next_sequence_.load(std::memory_order_acquire);
+        }
+
+        void advance_sequence_watermark(const size_t next_sequence) {
+            size_t current = next_sequence_.load(std::memory_order_relaxed);
+            while (current < next_sequence &&
+                !next_sequence_.compare_exchange_weak(current, next_sequence, std::memory_order_release)) {
+            }
+        }
+
+        [[nodiscard]] size_t queue_capacity() const {
+            return queue_capacity_;
+        }
+
+        void set_queue_capacity(const size_t queue_capacity) {
+            queue_capacity_ = queue_capacity;
+        }
+
+        [[nodiscard]] size_t memory_budget_bytes() const {
+            return memory_budget_bytes_;
+        }
+
+        [[nodiscard]] QueueEngine queue_engine() const {
+            return queue_engine_;
+        }
+
+        [[nodiscard]] const RingAllocation& ring_allocation() const {
+            return ring_allocation_;
         }
 
     private:
         std::string name_;
-        size_t partition_count_;
+        std::atomic<size_t> partition_count_; // only grows, see EventBus::repartition_topic
+        size_t queue_capacity_;
+        size_t memory_budget_bytes_;
+        QueueEngine queue_engine_;
+        RingAllocation ring_allocation_;
+        bool static_partition_count_;
+        KeylessPartitioning keyless_partitioning_;
+        bool total_order_;
+        bool replicated_;
+        std::optional<JsonKeyScanner> partition_key_scanner_;
+        GracePeriod routing_grace_period_;
+        RcuPtr<TopicRoutes> routes_; // swapped when groups or partitions are added
+        std::deque<std::mutex> fan_out_locks_; // see fan_out_lock(), grows with the partitions
+        // Both taken by every publish of a total order topic, each on a cache line of its own so the two do not
+        // bounce one line between producers
+        alignas(64) std::atomic<size_t> next_message_id_{0};
+        alignas(64) std::atomic<size_t> next_sequence_{1}; // only moves on total order topics
     };
 }
 
@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "event_bus.hpp"
+
+using namespace eventbus;
+
+static EventBusConfig payments_config(const bool acknowledged, const size_t partition_count = 1) {
+    TopicConfig topic{"payments", partition_count};
+    topic.queue_capacity = 8;
+    ConsumerGroupConfig group{"settlement", "payments", 1};
+    group.acknowledged = acknowledged;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back(group);
+    return config;
+}
+
+static size_t publish(EventBus& event_bus, const int first, const int count) {
+    size_t published = 0;
+    for (int i = first; i < first + count; ++i) {
+        published += event_bus.publish_event(Event("payments", std::to_string(i))) ? 1 : 0;
+    }
+    return published;
+}
+
+static std::vector<std::string> payloads(const std::vector<Event>& events) {
+    std::vector<std::string> result;
+    for (const auto& event : events) {
+        result.push_back(event.payload);
+    }
+    return result;
+}
+
+// Polled but unacknowledged events keep their slots, acknowledging one frees it and everything before it
+static void unacknowledged_events_hold_their_slots() {
+    EventBus event_bus(payments_config(true));
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("settlement")[0];
+    CHECK(publish(event_bus, 0, 10) == 8);
+    const std::vector<Event>& batch = consumer.poll_batch(16);
+    CHECK(batch.size() == 8);
+    CHECK(publish(event_bus, 8, 1) == 0);
+
+    consumer.acknowledge(batch[3]);
+    CHECK(publish(event_bus, 8, 8) == 4);
+    consumer.acknowledge();
+    CHECK(publish(event_bus, 12, 8) == 4);
+}
+
+// Redelivery starts again at the first unacknowledged event, acknowledged ones never come back
+static void redelivery_resumes_after_the_last_acknowledgement() {
+    EventBus event_bus(payments_config(true));
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("settlement")[0];
+    CHECK(publish(event_bus, 0, 6) == 6);
+    const std::vector<Event>& batch = consumer.poll_batch(4);
+    CHECK(batch.size() == 4);
+    consumer.acknowledge(batch[1]);
+
+    consumer.redeliver_unacknowledged();
+    CHECK(payloads(consumer.poll_batch(16)) == std::vector<std::string>({"2", "3", "4", "5"}));
+    consumer.redeliver_unacknowledged();
+    CHECK(payloads(consumer.poll_batch(16)) == std::vector<std::string>({"2", "3", "4", "5"}));
+    consumer.acknowledge();
+    consumer.redeliver_unacknowledged();
+    CHECK(consumer.poll_batch(16).empty());
+}
+
+// Acknowledging is per partition lane, other partitions keep what they have not acknowledged
+static void acknowledgements_are_per_partition() {
+    EventBus event_bus(payments_config(true, 2));
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("settlement")[0];
+    for (int i = 0; i < 8; ++i) {
+        CHECK(event_bus.publish_event(Event("payments", std::to_string(i)), i % 2 == 0 ? "even" : "odd"));
+    }
+    const std::vector<Event>& batch = consumer.poll_batch(16);
+    CHECK(batch.size() == 8);
+    const std::string acknowledged_parity = std::stoi(batch.back().payload) % 2 == 0 ? "even" : "odd";
+    consumer.acknowledge(batch.back());
+
+    consumer.redeliver_unacknowledged();
+    const std::vector<Event>& redelivered = consumer.poll_batch(16);
+    CHECK(redelivered.size() == 4);
+    for (const auto& event : redelivered) {
+        CHECK((std::stoi(event.payload) % 2 == 0 ? "even" : "odd") != acknowledged_parity);
+    }
+}
+
+static void plain_groups_refuse_acknowledgements() {
+    EventBus event_bus(payments_config(false));
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("settlement")[0];
+    CHECK(publish(event_bus, 0, 1) == 1);
+    CHECK(consumer.poll_batch(16).size() == 1);
+    CHECK(throws_runtime_error([&] { consumer.acknowledge(); }));
+    CHECK(throws_runtime_error([&] { consumer.redeliver_unacknowledged(); }));
+}
+
+int main() {
+    unacknowledged_events_hold_their_slots();
+    redelivery_resumes_after_the_last_acknowledgement();
+    acknowledgements_are_per_partition();
+    plain_groups_refuse_acknowledgements();
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include <chrono>
+#include <thread>
+
+#include "check.hpp"
+#include "event_bus.hpp"
+
+using namespace eventbus;
+
+// A consumer that idles between polls but handles its batches instantly keeps growing them under backlog
+static void idle_time_is_not_handler_cost() {
+    TopicConfig topic{"clicks", 1};
+    topic.queue_capacity = 1024;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"analytics", "clicks", 1});
+    EventBus event_bus(config);
+    for (int i = 0; i < 1000; ++i) {
+        CHECK(event_bus.publish_event(Event("clicks", "click")));
+    }
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("analytics")[0];
+    AdaptiveBatchConfig adaptive_config;
+    adaptive_config.latency_target = std::chrono::milliseconds(10);
+    adaptive_config.min_batch = 1;
+    adaptive_config.max_batch = 64;
+    consumer.set_adaptive_batching(adaptive_config);
+
+    for (int poll = 0; poll < 8; ++poll) {
+        CHECK(!consumer.poll_adaptive_batch().empty());
+        consumer.adaptive_batch_handled();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(consumer.adaptive_batch_size() == 64);
+}
+
+int main() {
+    idle_time_is_not_handler_cost();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <vector>
+
+#include "check.hpp"
+#include "consumer.hpp"
+#include "event_bus.hpp"
+
+using namespace eventbus;
+
+static EventBusConfig config_with_capacity(const size_t queue_capacity) {
+    TopicConfig topic{"orders", 2};
+    topic.queue_capacity = queue_capacity;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"billing", "orders", 1});
+    return config;
+}
+
+static EventBusConfig config_with_initial_capacity(const size_t initial_queue_capacity, const QueueEngine queue_engine) {
+    EventBusConfig config = config_with_capacity(64);
+    config.topics[0].partition_count = 1;
+    config.topics[0].initial_queue_capacity = initial_queue_capacity;
+    config.topics[0].queue_engine = queue_engine;
+    return config;
+}
+
+// A lane starting at initial_queue_capacity has to grow to take the whole burst, losing nothing on the way
+static void check_growth(const size_t initial_queue_capacity, const QueueEngine queue_engine) {
+    EventBus event_bus(config_with_initial_capacity(initial_queue_capacity, queue_engine));
+    constexpr size_t event_count = 64;
+    for (size_t i = 0; i < event_count; ++i) {
+        CHECK(event_bus.publish_event(Event("orders", std::to_string(i))));
+    }
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    std::vector<bool> seen(event_count, false);
+    size_t consumed = 0;
+    for (const Event& event : consumer.poll_batch(event_count * 2)) {
+        const size_t index = std::stoul(event.payload);
+        CHECK(index < event_count && !seen[index]);
+        seen[index] = true;
+        ++consumed;
+    }
+    CHECK(consumed == event_count);
+}
+
+int main() {
+    CHECK(throws_runtime_error([] { EventBus event_bus(config_with_capacity(0)); }));
+    CHECK(throws_runtime_error([] { EventBus event_bus(config_with_capacity(1)); }));
+    CHECK(throws_runtime_error([] { EventBus event_bus(config_with_capacity(3)); }));
+
+    EventBus event_bus(config_with_capacity(2));
+    for (const size_t queue_capacity : {0, 1, 3}) {
+        RuntimeConfigUpdate update;
+        update.queue_capacity_by_topic["orders"] = queue_capacity;
+        CHECK(throws_runtime_error([&] { event_bus.apply_runtime_config(update); }));
+        update = {};
+        update.queue_capacity_by_group["billing"] = queue_capacity;
+        CHECK(throws_runtime_error([&] { event_bus.apply_runtime_config(update); }));
+    }
+    RuntimeConfigUpdate update;
+    update.queue_capacity_by_group["billing"] = 4;
+    event_bus.apply_runtime_config(update);
+
+    for (const QueueEngine queue_engine : {QueueEngine::CAS_RING, QueueEngine::FETCH_ADD_RING, QueueEngine::RELAXED_RING}) {
+        CHECK(throws_runtime_error([&] { EventBus bus(config_with_initial_capacity(1, queue_engine)); }));
+        CHECK(throws_runtime_error([&] { EventBus bus(config_with_initial_capacity(3, queue_engine)); }));
+        CHECK(throws_runtime_error([&] { EventBus bus(config_with_initial_capacity(128, queue_engine)); }));
+        for (const size_t initial_queue_capacity : {2, 4, 8}) {
+            check_growth(initial_queue_capacity, queue_engine);
+        }
+    }
+    return 0;
+}
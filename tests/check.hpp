@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Minimal assertions for the ctest targets, independent of NDEBUG
+#define CHECK(condition)                                                                       \
+    do {                                                                                       \
+        if (!(condition)) {                                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition "\n";    \
+            std::exit(1);                                                                      \
+        }                                                                                      \
+    } while (false)
+
+inline bool throws_runtime_error(const std::function<void()>& action) {
+    try {
+        action();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
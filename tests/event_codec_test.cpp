@@ -0,0 +1,159 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "event_codec.hpp"
+#include "lz_block_codec.hpp"
+
+using namespace eventbus;
+
+static std::vector<Event> sample_events(const size_t count) {
+    std::vector<Event> events;
+    for (size_t i = 0; i < count; ++i) {
+        Event event(i % 2 == 0 ? "orders" : "payments", R"({"user":"user_)" + std::to_string(i % 7) + R"(","amount":42})");
+        event.id = i + 1;
+        events.push_back(event);
+    }
+    return events;
+}
+
+static void check_same_events(const std::vector<Event>& expected, const std::vector<Event>& actual) {
+    CHECK(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        CHECK(actual[i].topic == expected[i].topic);
+        CHECK(actual[i].payload == expected[i].payload);
+        CHECK(actual[i].id == expected[i].id);
+    }
+}
+
+// Frames decode back to back, compressed or not, and an empty batch is a valid frame
+static void batches_round_trip() {
+    const std::vector<Event> events = sample_events(500);
+    std::string frames;
+    EventBatchCodec::encode(events, frames, true);
+    const size_t compressed_frame_size = frames.size();
+    EventBatchCodec::encode(events, frames, false);
+    EventBatchCodec::encode({}, frames);
+    CHECK(compressed_frame_size < frames.size() - compressed_frame_size);
+
+    std::vector<Event> decoded;
+    size_t pos = EventBatchCodec::decode(frames.data(), frames.size(), decoded);
+    check_same_events(events, decoded);
+    decoded.clear();
+    pos += EventBatchCodec::decode(frames.data() + pos, frames.size() - pos, decoded);
+    check_same_events(events, decoded);
+    decoded.clear();
+    pos += EventBatchCodec::decode(frames.data() + pos, frames.size() - pos, decoded);
+    CHECK(decoded.empty());
+    CHECK(pos == frames.size());
+}
+
+// Overlapping matches, long literal runs and incompressible bytes all survive the block codec
+static void blocks_round_trip() {
+    std::string repetitive(100000, 'a');
+    std::string mixed;
+    uint32_t state = 12345;
+    for (size_t i = 0; i < 70000; ++i) {
+        state = state * 1103515245u + 12345u;
+        mixed.push_back(i % 1000 < 500 ? static_cast<char>(state >> 24) : static_cast<char>('x' + i % 3));
+    }
+    for (const std::string* input : {&repetitive, &mixed}) {
+        std::string compressed;
+        LzBlockCodec::compress(input->data(), input->size(), compressed);
+        CHECK(compressed.size() <= LzBlockCodec::max_compressed_size(input->size()));
+        std::string restored = "prefix";
+        LzBlockCodec::decompress(compressed.data(), compressed.size(), input->size(), restored);
+        CHECK(restored == "prefix" + *input);
+    }
+}
+
+static bool decode_throws(const std::string& frame) {
+    return throws_runtime_error([&] {
+        std::vector<Event> decoded;
+        EventBatchCodec::decode(frame.data(), frame.size(), decoded);
+    });
+}
+
+static void malformed_frames_are_rejected() {
+    std::string frame;
+    EventBatchCodec::encode(sample_events(100), frame, true);
+
+    CHECK(decode_throws(frame.substr(0, EventBatchCodec::FRAME_HEADER_SIZE - 1)));
+    CHECK(decode_throws(frame.substr(0, frame.size() - 1)));
+    std::string bad_magic = frame;
+    bad_magic[0] ^= 0x20;
+    CHECK(decode_throws(bad_magic));
+    std::string wrong_raw_size = frame;
+    wrong_raw_size[9] ^= 0x01; // low byte of the raw body size
+    CHECK(decode_throws(wrong_raw_size));
+    std::string more_events = frame;
+    more_events[6] ^= 0x01; // 256 more events than the body holds
+    CHECK(decode_throws(more_events));
+
+    std::string compressed;
+    const std::string input(1000, 'z');
+    LzBlockCodec::compress(input.data(), input.size(), compressed);
+    std::string restored;
+    CHECK(throws_runtime_error([&] {
+        LzBlockCodec::decompress(compressed.data(), compressed.size() - 1, input.size(), restored);
+    }));
+    std::string bad_offset = compressed;
+    bad_offset[2] = static_cast<char>(0xFF);
+    bad_offset[3] = static_cast<char>(0xFF);
+    restored.clear();
+    CHECK(throws_runtime_error([&] {
+        LzBlockCodec::decompress(bad_offset.data(), bad_offset.size(), input.size(), restored);
+    }));
+}
+
+// Sizes from the header are checked against the input before anything is reserved for them
+static void header_sizes_are_not_trusted() {
+    std::string frame;
+    EventBatchCodec::encode(sample_events(10), frame, false);
+    for (size_t i = 5; i < 9; ++i) {
+        frame[i] = static_cast<char>(0xFF); // four billion events in a body of ten
+    }
+    CHECK(decode_throws(frame));
+
+    std::string compressed;
+    const std::string input(1000, 'z');
+    LzBlockCodec::compress(input.data(), input.size(), compressed);
+    std::string restored;
+    CHECK(throws_runtime_error([&] {
+        LzBlockCodec::decompress(compressed.data(), compressed.size(), LzBlockCodec::MAX_BLOCK_SIZE + 1, restored);
+    }));
+    CHECK(throws_runtime_error([&] {
+        LzBlockCodec::decompress(compressed.data(), compressed.size(),
+            LzBlockCodec::max_decompressed_size(compressed.size()) + 1, restored);
+    }));
+}
+
+// Timestamps travel as wall clock time and come back with their age, frames with raw steady ticks drop them
+static void timestamps_keep_their_age() {
+    std::vector<Event> events = sample_events(2);
+    events[0].timestamp = std::chrono::steady_clock::now() - std::chrono::seconds(10);
+    std::string frame;
+    EventBatchCodec::encode(events, frame, false);
+
+    std::vector<Event> decoded;
+    EventBatchCodec::decode(frame.data(), frame.size(), decoded);
+    const auto age = std::chrono::steady_clock::now() - decoded[0].timestamp;
+    CHECK(age >= std::chrono::seconds(10) && age < std::chrono::seconds(11));
+    CHECK(decoded[0].timestamp < decoded[1].timestamp);
+
+    frame[4] = static_cast<char>(frame[4] & ~EventBatchCodec::FLAG_WALL_CLOCK_TIMESTAMPS);
+    decoded.clear();
+    EventBatchCodec::decode(frame.data(), frame.size(), decoded);
+    CHECK(decoded[0].timestamp == std::chrono::steady_clock::time_point());
+    CHECK(decoded[1].timestamp == std::chrono::steady_clock::time_point());
+}
+
+int main() {
+    batches_round_trip();
+    blocks_round_trip();
+    malformed_frames_are_rejected();
+    header_sizes_are_not_trusted();
+    timestamps_keep_their_age();
+    return 0;
+}
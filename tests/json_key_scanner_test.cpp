@@ -0,0 +1,72 @@
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "json_key_scanner.hpp"
+
+using namespace eventbus;
+
+static bool extracts(const std::string& path, const std::string& json, const std::string& expected) {
+    std::string_view key;
+    return JsonKeyScanner(path).extract(json, key) && key == expected;
+}
+
+static bool finds_nothing(const std::string& path, const std::string& json) {
+    std::string_view key;
+    return !JsonKeyScanner(path).extract(json, key);
+}
+
+static void top_level_fields() {
+    CHECK(extracts("user", R"({"user":"bob"})", "bob"));
+    CHECK(extracts("user", R"({ "amount" : 42 , "user" : "bob" })", "bob"));
+    CHECK(extracts("amount", R"({"user":"bob","amount":42})", "42"));
+    CHECK(extracts("amount", "{\"amount\":-1.5e3\n}", "-1.5e3"));
+    CHECK(extracts("active", R"({"active":true})", "true"));
+    CHECK(extracts("user", R"({"x":"user","user":"bob"})", "bob")); // a value equal to the name is no key
+    const std::string padding(100, 'p');
+    CHECK(extracts("user", R"({"padding":")" + padding + R"(","user":"after a long string"})", "after a long string"));
+}
+
+// Only keys of the objects on the path count, deeper or sibling fields with the same name do not
+static void nested_paths() {
+    const std::string json = R"({"user":"top","order":{"items":[{"user":"in array"}],"customer":{"user":"nested"}}})";
+    CHECK(extracts("user", json, "top"));
+    CHECK(extracts("order.customer.user", json, "nested"));
+    CHECK(finds_nothing("order.user", json));
+    CHECK(finds_nothing("order.items", json));
+    CHECK(finds_nothing("order.customer", json));
+    CHECK(extracts("a.b", R"({"b":"wrong","a":{"c":{"b":"deeper"},"b":"right"}})", "right"));
+    CHECK(finds_nothing("a.b", R"({"a":"not an object","b":"x"})"));
+}
+
+// Escapes are skipped while scanning and returned undecoded
+static void escaped_strings() {
+    CHECK(extracts("user", R"({"note":"{\"user\":\"fake\"}","user":"bob"})", "bob"));
+    CHECK(extracts("user", R"({"us\"er":"fake","user":"bob"})", "bob"));
+    CHECK(extracts("user", R"({"note":"ends with a backslash \\","user":"bob"})", "bob"));
+    CHECK(extracts("user", R"({"user":"say \"hi\""})", R"(say \"hi\")"));
+}
+
+static void malformed_input() {
+    CHECK(finds_nothing("user", ""));
+    CHECK(finds_nothing("user", "not json"));
+    CHECK(finds_nothing("user", R"({"user")"));
+    CHECK(finds_nothing("user", R"({"user":)"));
+    CHECK(finds_nothing("user", R"({"user":"unterminated)"));
+    CHECK(finds_nothing("user", R"({"note":"unterminated,"user":"bob")"));
+    CHECK(finds_nothing("user", R"({"user":,"x":1})"));
+    CHECK(finds_nothing("user", "{\"note\":\"trailing backslash\\"));
+    CHECK(finds_nothing("user", R"({"user":{"id":1}})"));
+    CHECK(finds_nothing("user", R"({"user":[1,2]})"));
+    CHECK(finds_nothing("user", R"(}}]]{"user":"bob"})"));
+    CHECK(throws_runtime_error([] { JsonKeyScanner scanner("order..user"); }));
+    CHECK(throws_runtime_error([] { JsonKeyScanner scanner(""); }));
+}
+
+int main() {
+    top_level_fields();
+    nested_paths();
+    escaped_strings();
+    malformed_input();
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <atomic>
+#include <thread>
+
+#include "check.hpp"
+#include "event_bus.hpp"
+#include "publisher.hpp"
+
+using namespace eventbus;
+
+// Two partitions of 64 slots, consumer 1 keeps draining while consumer 0 stalls. Returns how many publishes fit.
+static size_t publish_with_stalled_consumer(const KeylessPartitioning keyless_partitioning, size_t& stalled_depth) {
+    TopicConfig topic{"clicks", 2};
+    topic.queue_capacity = 64;
+    topic.keyless_partitioning = keyless_partitioning;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"analytics", "clicks", 2});
+    EventBus event_bus(config);
+    const auto& consumers = event_bus.consumers_by_consumer_group_id().at("analytics");
+
+    size_t published = 0;
+    for (int i = 0; i < 1000; ++i) {
+        published += event_bus.publish_event(Event("clicks", "click")) ? 1 : 0;
+        (void)consumers[1]->poll_batch(16);
+    }
+    stalled_depth = consumers[0]->poll_batch(1000).size();
+    return published;
+}
+
+// Round robin keeps feeding the stalled partition until it drops, least loaded steers around it
+static void least_loaded_avoids_a_stalled_partition() {
+    size_t stalled_depth = 0;
+    CHECK(publish_with_stalled_consumer(KeylessPartitioning::ROUND_ROBIN, stalled_depth) < 1000);
+    CHECK(stalled_depth == 64);
+
+    CHECK(publish_with_stalled_consumer(KeylessPartitioning::LEAST_LOADED, stalled_depth) == 1000);
+    CHECK(stalled_depth <= 1);
+}
+
+// Keyed events keep their partition whatever the keyless strategy
+static void keyed_events_ignore_depth() {
+    TopicConfig topic{"clicks", 4};
+    topic.keyless_partitioning = KeylessPartitioning::LEAST_LOADED;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"analytics", "clicks", 4});
+    EventBus event_bus(config);
+    for (int i = 0; i < 100; ++i) {
+        CHECK(event_bus.publish_event(Event("clicks", "click"), "user_1"));
+    }
+    size_t non_empty = 0;
+    for (const auto& consumer : event_bus.consumers_by_consumer_group_id().at("analytics")) {
+        const size_t polled = consumer->poll_batch(1000).size();
+        CHECK(polled == 0 || polled == 100);
+        non_empty += polled != 0 ? 1 : 0;
+    }
+    CHECK(non_empty == 1);
+}
+
+// Least loaded routing in a Publisher reads ring depths while reloads retire and free those rings
+static void publisher_survives_capacity_reloads() {
+    TopicConfig topic{"clicks", 4};
+    topic.queue_capacity = 64;
+    topic.keyless_partitioning = KeylessPartitioning::LEAST_LOADED;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"analytics", "clicks", 1});
+    EventBus event_bus(config);
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("analytics")[0];
+
+    std::atomic<bool> reloading{true};
+    std::thread reloader([&] {
+        for (size_t round = 0; round < 500; ++round) {
+            RuntimeConfigUpdate update;
+            update.queue_capacity_by_topic["clicks"] = round % 2 == 0 ? 128 : 64;
+            event_bus.apply_runtime_config(update);
+            std::this_thread::yield();
+        }
+        reloading.store(false, std::memory_order_relaxed);
+    });
+    std::thread draining([&] { // frees the retired rings while the publisher may still look at them
+        while (reloading.load(std::memory_order_relaxed)) {
+            (void)consumer.poll_batch(256);
+        }
+    });
+    {
+        Publisher publisher(event_bus);
+        while (reloading.load(std::memory_order_relaxed)) {
+            (void)publisher.publish(Event("clicks", "click"));
+        }
+    }
+    reloader.join();
+    draining.join();
+}
+
+int main() {
+    least_loaded_avoids_a_stalled_partition();
+    keyed_events_ignore_depth();
+    publisher_survives_capacity_reloads();
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <poll.h>
+
+#include "check.hpp"
+#include "consumer.hpp"
+#include "event_bus.hpp"
+
+using namespace eventbus;
+
+static bool is_readable(const int fd) {
+    pollfd poll_fd{fd, POLLIN, 0};
+    return poll(&poll_fd, 1, 0) == 1;
+}
+
+// A partition added by a repartition is fenced until the old partitions are consumed past the cut. Its consumer
+// must be able to wait on the fd meanwhile, and wake once another consumer has read the old partitions.
+int main() {
+    TopicConfig topic{"orders", 1};
+    topic.queue_capacity = 256;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"billing", "orders", 2});
+    EventBus event_bus(config);
+    Consumer& old_partition_consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    Consumer& new_partition_consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[1];
+    const int fd = new_partition_consumer.enable_notification();
+
+    for (int i = 0; i < 16; ++i) {
+        CHECK(event_bus.publish_event(Event("orders", "before"), "key-" + std::to_string(i)));
+    }
+    event_bus.repartition_topic("orders", 2);
+    for (int i = 0; i < 64; ++i) {
+        CHECK(event_bus.publish_event(Event("orders", "after"), "key-" + std::to_string(i)));
+    }
+
+    CHECK(new_partition_consumer.poll_batch(256).empty());
+    CHECK(new_partition_consumer.arm_notification());
+    CHECK(!is_readable(fd));
+
+    CHECK(!old_partition_consumer.poll_batch(256).empty());
+    CHECK(is_readable(fd));
+    CHECK(!new_partition_consumer.poll_batch(256).empty());
+    CHECK(new_partition_consumer.arm_notification());
+    return 0;
+}
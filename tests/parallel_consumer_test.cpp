@@ -0,0 +1,78 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "consumer.hpp"
+#include "event_bus.hpp"
+#include "parallel_consumer.hpp"
+
+using namespace eventbus;
+
+static EventBusConfig orders_config(const bool acknowledged) {
+    EventBusConfig config;
+    config.topics.push_back({"orders", 1});
+    ConsumerGroupConfig group{"billing", "orders", 1};
+    group.acknowledged = acknowledged;
+    config.consumer_groups.push_back(group);
+    return config;
+}
+
+// Dispatches ten events, the handler fails on the one in failing_payload
+static std::unique_ptr<ParallelConsumer> dispatch_ten(EventBus& event_bus, const Consumer& consumer,
+    const std::string& failing_payload) {
+    ParallelConsumerConfig parallel_config;
+    parallel_config.worker_count = 2;
+    auto parallel = std::make_unique<ParallelConsumer>(consumer, [failing_payload](const Event& event) {
+        if (event.payload == failing_payload) {
+            throw std::runtime_error("handler failed");
+        }
+    }, parallel_config);
+
+    for (int i = 0; i < 10; ++i) {
+        CHECK(event_bus.publish_event(Event("orders", std::to_string(i))));
+    }
+    CHECK(parallel->poll_and_dispatch(256) == 10);
+    while (!parallel->idle()) {
+        std::this_thread::yield();
+    }
+    return parallel;
+}
+
+// A throwing handler must neither terminate the process nor let the watermark pass the failed event
+static void failed_event_holds_the_watermark() {
+    EventBus event_bus(orders_config(false));
+    const Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    const auto parallel = dispatch_ten(event_bus, consumer, "5");
+    CHECK(parallel->completed_position(0) == 5);
+    CHECK(throws_runtime_error([&] { parallel->poll_and_dispatch(256); }));
+    CHECK(throws_runtime_error([&] { parallel->poll_and_dispatch(256); }));
+}
+
+// In an acknowledged group the watermark is committed, a redelivery starts again at the failed event
+static void watermark_is_acknowledged() {
+    EventBus event_bus(orders_config(true));
+    const Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    auto parallel = dispatch_ten(event_bus, consumer, "5");
+    CHECK(parallel->completed_position(0) == 5);
+    parallel.reset();
+
+    consumer.redeliver_unacknowledged();
+    const std::vector<Event>& redelivered = consumer.poll_batch(16);
+    CHECK(redelivered.size() == 5);
+    CHECK(redelivered.front().payload == "5");
+    consumer.acknowledge();
+
+    parallel = dispatch_ten(event_bus, consumer, "none");
+    parallel.reset(); // commits everything handled
+    consumer.redeliver_unacknowledged();
+    CHECK(consumer.poll_batch(16).empty());
+}
+
+int main() {
+    failed_event_holds_the_watermark();
+    watermark_is_acknowledged();
+    return 0;
+}
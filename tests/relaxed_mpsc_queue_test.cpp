@@ -0,0 +1,49 @@
+#include <vector>
+
+#include "check.hpp"
+#include "relaxed_mpsc_queue.hpp"
+
+using namespace eventbus;
+
+// Fills the ring, drains it, and repeats, so every lane wraps around at least once
+static void check_round_trip(const size_t capacity) {
+    RelaxedMpscQueue<int> queue(capacity);
+    CHECK(queue.capacity() == capacity);
+    int next = 0;
+    for (int round = 0; round < 4; ++round) {
+        size_t enqueued = 0;
+        while (queue.enqueue(next)) {
+            ++next;
+            ++enqueued;
+        }
+        CHECK(enqueued == capacity);
+
+        std::vector<bool> seen(next, false);
+        size_t dequeued = 0;
+        int item = 0;
+        while (queue.dequeue(item)) {
+            CHECK(item >= next - static_cast<int>(capacity) && item < next);
+            CHECK(!seen[item]);
+            seen[item] = true;
+            ++dequeued;
+        }
+        CHECK(dequeued == capacity);
+        CHECK(queue.size_approx() == 0);
+    }
+
+    std::vector<int> batch(capacity * 2, 7);
+    CHECK(queue.enqueue_batch(batch.data(), batch.size()) == capacity);
+    std::vector<int> out;
+    CHECK(queue.dequeue_batch(out, capacity * 2, 0) == capacity);
+}
+
+int main() {
+    check_round_trip(2);
+    check_round_trip(4);
+    check_round_trip(8);
+    check_round_trip(64);
+
+    CHECK(throws_runtime_error([] { RelaxedMpscQueue<int> queue(1); }));
+    CHECK(throws_runtime_error([] { RelaxedMpscQueue<int> queue(0); }));
+    return 0;
+}
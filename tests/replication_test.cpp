@@ -0,0 +1,152 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "check.hpp"
+#include "event_bus.hpp"
+#include "replication.hpp"
+
+using namespace eventbus;
+
+static EventBusConfig replicated_config() {
+    TopicConfig topic{"orders", 1};
+    topic.queue_capacity = 1024;
+    topic.replicated = true;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"billing", "orders", 1});
+    return config;
+}
+
+static BackPressureConfig blocking() {
+    BackPressureConfig back_pressure;
+    back_pressure.strategy = BackPressureStrategy::BLOCK;
+    return back_pressure;
+}
+
+// A standby that accepts the connection but never reads fills the socket buffers. The sender has to give up on it
+// after send_timeout instead of blocking, and publishers keep going.
+static void stalled_standby_is_disconnected() {
+    const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_size = sizeof(address);
+    CHECK(bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+    CHECK(listen(listen_fd, 1) == 0);
+    CHECK(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &address_size) == 0);
+
+    EventBus event_bus(replicated_config(), blocking());
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    ReplicationConfig replication_config;
+    replication_config.port = ntohs(address.sin_port);
+    replication_config.send_timeout = std::chrono::milliseconds(100);
+    ReplicationSender sender(event_bus, replication_config);
+    const int connection_fd = accept(listen_fd, nullptr, nullptr);
+    CHECK(connection_fd >= 0);
+
+    const std::string payload(4096, 'x');
+    for (int i = 0; i < 20000; ++i) {
+        CHECK(event_bus.publish_event(Event("orders", payload)));
+        CHECK(consumer.poll_batch(1000).size() <= 1000);
+    }
+    CHECK(!sender.is_connected());
+    close(connection_fd);
+    close(listen_fd);
+}
+
+// Without a sender the hidden group is drained by the bus, and it never shows up among the consumers
+static void unattached_replication_group_is_drained() {
+    EventBus event_bus(replicated_config(), blocking());
+    CHECK(event_bus.consumers_by_consumer_group_id().size() == 1);
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    for (int round = 0; round < 64; ++round) {
+        for (int i = 0; i < 512; ++i) {
+            CHECK(event_bus.publish_event(Event("orders", "payload"))); // blocks forever on an undrained group
+        }
+        CHECK(consumer.poll_batch(1024).size() == 512);
+    }
+}
+
+static void second_sender_is_refused() {
+    StandbyReplica standby;
+    EventBus event_bus(replicated_config(), blocking());
+    ReplicationConfig replication_config;
+    replication_config.port = standby.port();
+    {
+        ReplicationSender sender(event_bus, replication_config);
+        CHECK(throws_runtime_error([&] { ReplicationSender second(event_bus, replication_config); }));
+    }
+    ReplicationSender sender(event_bus, replication_config); // the first one is gone
+}
+
+// Racing producers fan out into a lane one at a time, so every group sees the same order and a takeover resumes
+// exactly at the cursor: what the group had not consumed comes back once, nothing it consumed comes back
+static void takeover_resumes_at_the_cursor() {
+    constexpr int PRODUCERS = 4;
+    constexpr int EVENTS_PER_PRODUCER = 200;
+    StandbyReplica standby;
+    EventBus event_bus(replicated_config(), blocking());
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    std::set<std::string> consumed;
+    {
+        ReplicationConfig replication_config;
+        replication_config.port = standby.port();
+        ReplicationSender sender(event_bus, replication_config);
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < PRODUCERS; ++producer) {
+            producers.emplace_back([&event_bus, producer] {
+                for (int i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                    const std::string payload = std::to_string(producer) + ":" + std::to_string(i);
+                    CHECK(event_bus.publish_event(Event("orders", payload)));
+                }
+            });
+        }
+        while (consumed.size() < 500) {
+            for (const auto& event : consumer.poll_batch(500 - consumed.size())) {
+                consumed.insert(event.payload);
+            }
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (std::chrono::steady_clock::now() < deadline &&
+               (sender.sent_events() < PRODUCERS * EVENTS_PER_PRODUCER || sender.acknowledged_frames() < sender.sent_frames())) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    EventBus standby_bus(replicated_config(), blocking());
+    standby.take_over(standby_bus);
+    const auto& events = standby_bus.consumers_by_consumer_group_id().at("billing")[0]->poll_batch(1024);
+    CHECK(events.size() == PRODUCERS * EVENTS_PER_PRODUCER - 500);
+    for (const auto& event : events) {
+        CHECK(consumed.insert(event.payload).second);
+    }
+    CHECK(consumed.size() == PRODUCERS * EVENTS_PER_PRODUCER);
+}
+
+// Any other strategy may drop an event in one group only, after which lane positions no longer line up
+static void replicated_topics_need_blocking_back_pressure() {
+    CHECK(throws_runtime_error([] { EventBus event_bus(replicated_config()); }));
+    EventBus event_bus(replicated_config(), blocking());
+    RuntimeConfigUpdate update;
+    update.back_pressure_strategy = BackPressureStrategy::DROP_NEWEST;
+    CHECK(throws_runtime_error([&] { event_bus.apply_runtime_config(update); }));
+}
+
+int main() {
+    stalled_standby_is_disconnected();
+    unattached_replication_group_is_drained();
+    second_sender_is_refused();
+    takeover_resumes_at_the_cursor();
+    replicated_topics_need_blocking_back_pressure();
+    return 0;
+}
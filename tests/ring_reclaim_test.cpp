@@ -0,0 +1,130 @@
+#include <vector>
+
+#include "check.hpp"
+#include "consumer.hpp"
+#include "event_bus.hpp"
+#include "grace_period.hpp"
+#include "partition_queue.hpp"
+
+using namespace eventbus;
+
+static size_t ring_bytes_of(const size_t capacity, const QueueEngine engine = QueueEngine::CAS_RING) {
+    return EventRing::memory_bytes_for_capacity(engine, capacity);
+}
+
+static void enqueue_guarded(GracePeriod& grace_period, PartitionLane& lane, const size_t count) {
+    const GracePeriod::ReadGuard guard(grace_period);
+    for (size_t i = 0; i < count; ++i) {
+        CHECK(lane.enqueue(Event("orders", std::to_string(i))));
+    }
+}
+
+// A growing lane frees every outgrown ring once the reader drained it
+static void outgrown_rings_are_freed() {
+    GracePeriod grace_period;
+    PartitionLane lane(64, QueueEngine::CAS_RING, RingAllocation{2, false, &grace_period});
+    enqueue_guarded(grace_period, lane, 64);
+    CHECK(lane.ring_bytes() > ring_bytes_of(64));
+    std::vector<Event> events;
+    CHECK(lane.dequeue_batch(events, 128, 0) == 64);
+    CHECK(lane.ring_bytes() == ring_bytes_of(64));
+}
+
+// A producer still inside its guard may hold the retired ring, it is only freed on a dequeue after it left
+static void retired_ring_waits_for_producers() {
+    GracePeriod grace_period;
+    PartitionLane lane(8, QueueEngine::CAS_RING, RingAllocation{0, false, &grace_period});
+    enqueue_guarded(grace_period, lane, 4);
+    std::vector<Event> events;
+    {
+        const GracePeriod::ReadGuard stalled_producer(grace_period);
+        lane.resize(16);
+        CHECK(lane.dequeue_batch(events, 16, 0) == 4);
+        CHECK(lane.ring_bytes() == ring_bytes_of(8) + ring_bytes_of(16));
+    }
+    CHECK(lane.dequeue_batch(events, 16, 0) == 0);
+    CHECK(lane.ring_bytes() == ring_bytes_of(16));
+}
+
+// Every reader of a broadcast lane has to be through, and on an acknowledged lane every commit cursor too
+static void retired_ring_waits_for_every_reader() {
+    GracePeriod grace_period;
+    PartitionLane broadcast_lane(8, QueueEngine::BROADCAST_RING, RingAllocation{0, false, &grace_period}, 2);
+    enqueue_guarded(grace_period, broadcast_lane, 4);
+    broadcast_lane.resize(16);
+    std::vector<Event> events;
+    CHECK(broadcast_lane.dequeue_batch(events, 16, 0, 0) == 4);
+    CHECK(broadcast_lane.dequeue_batch(events, 16, 0, 0) == 0);
+    CHECK(broadcast_lane.ring_bytes() == ring_bytes_of(8, QueueEngine::BROADCAST_RING) +
+          ring_bytes_of(16, QueueEngine::BROADCAST_RING));
+    CHECK(broadcast_lane.dequeue_batch(events, 16, 0, 1) == 4);
+    CHECK(broadcast_lane.dequeue_batch(events, 16, 0, 1) == 0);
+    CHECK(broadcast_lane.ring_bytes() == ring_bytes_of(16, QueueEngine::BROADCAST_RING));
+
+    PartitionLane acknowledged_lane(8, QueueEngine::CAS_RING, RingAllocation{0, false, &grace_period}, 1, true);
+    enqueue_guarded(grace_period, acknowledged_lane, 4);
+    acknowledged_lane.resize(16);
+    enqueue_guarded(grace_period, acknowledged_lane, 2);
+    events.clear();
+    CHECK(acknowledged_lane.dequeue_batch(events, 16, 0) == 6);
+    CHECK(acknowledged_lane.dequeue_batch(events, 16, 0) == 0);
+    CHECK(acknowledged_lane.ring_bytes() > ring_bytes_of(16, QueueEngine::BROADCAST_RING));
+    acknowledged_lane.redeliver();
+    events.clear();
+    CHECK(acknowledged_lane.dequeue_batch(events, 16, 0) == 6);
+    acknowledged_lane.acknowledge(6);
+    CHECK(acknowledged_lane.dequeue_batch(events, 16, 0) == 0);
+    CHECK(acknowledged_lane.ring_bytes() == ring_bytes_of(16, QueueEngine::BROADCAST_RING));
+}
+
+static EventBusConfig reload_config(const bool isolated_tenant) {
+    TopicConfig topic{"orders", 1};
+    topic.queue_capacity = 64;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"billing", "orders", 1});
+    if (isolated_tenant) {
+        TenantConfig tenant;
+        tenant.name = "acme";
+        tenant.isolated_queue_capacity = 32;
+        tenant.isolated_topics = {"orders"};
+        config.tenants.push_back(tenant);
+    }
+    return config;
+}
+
+// Repeated capacity reloads only ever keep the current ring once the consumer caught up
+static void reloads_do_not_accumulate_rings() {
+    EventBus event_bus(reload_config(false));
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("billing")[0];
+    for (const size_t queue_capacity : {128, 32, 256, 64}) {
+        CHECK(event_bus.publish_event(Event("orders", "before")));
+        RuntimeConfigUpdate update;
+        update.queue_capacity_by_topic["orders"] = queue_capacity;
+        event_bus.apply_runtime_config(update);
+        CHECK(event_bus.publish_event(Event("orders", "after")));
+        CHECK(consumer.poll_batch(16).size() == 2);
+        CHECK(consumer.poll_batch(16).empty());
+        CHECK(event_bus.memory_usage().total.ring_bytes == ring_bytes_of(queue_capacity));
+    }
+}
+
+// Tenant lanes are sized by their tenant, a reload must not leave them behind silently
+static void reload_of_isolated_group_is_rejected() {
+    EventBus event_bus(reload_config(true));
+    RuntimeConfigUpdate update;
+    update.queue_capacity_by_group["billing"] = 128;
+    CHECK(throws_runtime_error([&] { event_bus.apply_runtime_config(update); }));
+    update = {};
+    update.queue_capacity_by_topic["orders"] = 128;
+    CHECK(throws_runtime_error([&] { event_bus.apply_runtime_config(update); }));
+}
+
+int main() {
+    outgrown_rings_are_freed();
+    retired_ring_waits_for_producers();
+    retired_ring_waits_for_every_reader();
+    reloads_do_not_accumulate_rings();
+    reload_of_isolated_group_is_rejected();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "check.hpp"
+#include "consumer.hpp"
+#include "event_bus.hpp"
+#include "event_codec.hpp"
+#include "snapshot.hpp"
+
+using namespace eventbus;
+
+static void put_string(std::string& out, const std::string& value) {
+    EventBatchCodec::put_u32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// Version 2 layout, written before topics carried a sequence: one topic, one group with one partition of one lane
+static void write_v2_snapshot(const std::string& path) {
+    std::string out;
+    EventBatchCodec::put_u32(out, 0x53425645);
+    EventBatchCodec::put_u32(out, 2);
+    EventBatchCodec::put_u32(out, 1);
+    put_string(out, "orders");
+    EventBatchCodec::put_u64(out, 42);
+    EventBatchCodec::put_u32(out, 1);
+    put_string(out, "billing");
+    put_string(out, "orders");
+    EventBatchCodec::put_u32(out, 1);
+    EventBatchCodec::put_u32(out, 1);
+    EventBatchCodec::put_u64(out, 40);
+    EventBatchCodec::encode({Event("orders", "pending-1"), Event("orders", "pending-2")}, out);
+    std::ofstream(path, std::ios::binary).write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+static EventBusConfig make_config() {
+    TopicConfig topic{"orders", 1};
+    topic.total_order = true;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"billing", "orders", 1});
+    return config;
+}
+
+int main() {
+    const std::string path = "snapshot_test_v2.snapshot";
+    write_v2_snapshot(path);
+    const BusSnapshot snapshot = read_snapshot_file(path);
+    std::remove(path.c_str());
+    CHECK(snapshot.topics.size() == 1);
+    CHECK(snapshot.topics[0].next_message_id == 42);
+    CHECK(snapshot.topics[0].next_sequence == 1);
+    CHECK(snapshot.consumer_groups.size() == 1);
+    CHECK(snapshot.consumer_groups[0].partitions[0].lanes[0].cursor == 40);
+    CHECK(snapshot.consumer_groups[0].partitions[0].lanes[0].pending_events.size() == 2);
+
+    EventBus event_bus(make_config());
+    event_bus.restore_snapshot(snapshot);
+    CHECK(event_bus.publish_event(Event("orders", "new")));
+    const auto& events = event_bus.consumers_by_consumer_group_id().at("billing")[0]->poll_batch(16);
+    CHECK(events.size() == 3);
+    CHECK(events[0].payload == "pending-1" && events[1].payload == "pending-2" && events[2].payload == "new");
+    CHECK(events[2].sequence == 1);
+
+    // The current version round-trips the sequence
+    const std::string current_path = "snapshot_test_v3.snapshot";
+    write_snapshot_file(event_bus.capture_snapshot(), current_path);
+    const BusSnapshot current = read_snapshot_file(current_path);
+    std::remove(current_path.c_str());
+    CHECK(current.topics[0].next_sequence == 2);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <string>
+
+#include "check.hpp"
+#include "event_bus.hpp"
+
+using namespace eventbus;
+
+static size_t ring_bytes_of(const size_t capacity) {
+    return EventRing::memory_bytes_for_capacity(QueueEngine::CAS_RING, capacity);
+}
+
+static EventBusConfig two_topic_config() {
+    TopicConfig orders{"orders", 2};
+    orders.queue_capacity = 4;
+    TopicConfig audit{"audit", 2};
+    audit.queue_capacity = 4;
+    EventBusConfig config;
+    config.topics = {orders, audit};
+    TenantConfig acme;
+    acme.name = "acme";
+    acme.isolated_queue_capacity = 8;
+    acme.isolated_topics = {"orders"};
+    config.tenants.push_back(acme);
+    return config;
+}
+
+// An isolated tenant gets its own lane on the topics it publishes to and the shared lane everywhere else
+static void isolated_lanes_only_on_their_topics() {
+    EventBusConfig config = two_topic_config();
+    config.consumer_groups = {{"billing", "orders", 1}, {"archive", "audit", 1}};
+    EventBus event_bus(config);
+    const TenantTag acme = event_bus.tenant_tag("acme");
+
+    size_t published = 0;
+    for (int i = 0; i < 32; ++i) {
+        published += event_bus.publish_event(acme, Event("orders", "burst"), "key") ? 1 : 0;
+    }
+    CHECK(published == 8);
+    CHECK(event_bus.publish_event(Event("orders", "shared"), "key"));
+
+    published = 0;
+    for (int i = 0; i < 32; ++i) {
+        published += event_bus.publish_event(acme, Event("audit", "burst"), "key") ? 1 : 0;
+    }
+    CHECK(published == 4);
+    CHECK(!event_bus.publish_event(Event("audit", "shared"), "key"));
+
+    const BusMemoryUsage usage = event_bus.memory_usage();
+    CHECK(usage.by_tenant.at("acme").ring_bytes == 2 * ring_bytes_of(8));
+    CHECK(usage.by_topic.at("audit").ring_bytes == 2 * ring_bytes_of(4));
+}
+
+// Groups on topics the tenant does not publish to neither carry its lanes nor count against its budget
+static void other_topics_do_not_charge_the_tenant() {
+    EventBusConfig config = two_topic_config();
+    config.tenants[0].memory_budget_bytes = 2 * ring_bytes_of(8);
+    config.consumer_groups = {{"billing", "orders", 1}};
+    for (int i = 0; i < 4; ++i) {
+        config.consumer_groups.push_back({"archive_" + std::to_string(i), "audit", 1});
+    }
+    EventBus event_bus(config);
+    CHECK(event_bus.memory_usage().by_tenant.at("acme").ring_bytes == 2 * ring_bytes_of(8));
+
+    config.consumer_groups.push_back({"fraud", "orders", 1});
+    CHECK(throws_runtime_error([&] { EventBus over_budget(config); }));
+}
+
+static void isolated_topics_are_validated() {
+    EventBusConfig config = two_topic_config();
+    config.tenants[0].isolated_topics.clear();
+    CHECK(throws_runtime_error([&] { EventBus event_bus(config); }));
+
+    config = two_topic_config();
+    config.tenants[0].isolated_topics = {"payments"};
+    CHECK(throws_runtime_error([&] { EventBus event_bus(config); }));
+
+    config = two_topic_config();
+    config.tenants[0].isolated_queue_capacity = 0;
+    CHECK(throws_runtime_error([&] { EventBus event_bus(config); }));
+}
+
+int main() {
+    isolated_lanes_only_on_their_topics();
+    other_topics_do_not_charge_the_tenant();
+    isolated_topics_are_validated();
+    return 0;
+}
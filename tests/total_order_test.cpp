@@ -0,0 +1,118 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "event_bus.hpp"
+#include "publisher.hpp"
+
+using namespace eventbus;
+
+static EventBusConfig ledger_config(const bool total_order) {
+    TopicConfig topic{"ledger", 4};
+    topic.queue_capacity = 8192;
+    topic.total_order = total_order;
+    EventBusConfig config;
+    config.topics.push_back(topic);
+    config.consumer_groups.push_back({"audit", "ledger", 1});
+    return config;
+}
+
+static Consumer& merging_consumer(EventBus& event_bus) {
+    Consumer& consumer = *event_bus.consumers_by_consumer_group_id().at("audit")[0];
+    MergeConfig merge_config;
+    merge_config.lookahead = 256;
+    merge_config.max_skew = std::chrono::seconds(1); // nothing is dropped, a gap is only an event deeper in a ring
+    merge_config.order = MergeOrder::SEQUENCE;
+    consumer.set_merge_ordering(merge_config);
+    return consumer;
+}
+
+static std::vector<Event> poll_all(Consumer& consumer, const size_t expected) {
+    std::vector<Event> events;
+    for (int idle = 0; events.size() < expected && idle < 1000; ++idle) {
+        for (const auto& event : consumer.poll_merged_batch(256)) {
+            events.push_back(event);
+            idle = 0;
+        }
+    }
+    return events;
+}
+
+// Single publishes and Publisher flushes share one counter. A flush takes its sequences partition by partition, so
+// its events come back between the single publishes around it, in key order within the flush.
+static void single_publishes_and_flushes_share_the_sequence() {
+    EventBus event_bus(ledger_config(true));
+    Publisher publisher(event_bus);
+    for (int i = 0; i < 1000; ++i) {
+        const std::string key = "account_" + std::to_string(i % 13);
+        if (i % 100 < 50) {
+            CHECK(event_bus.publish_event(Event("ledger", std::to_string(i)), key));
+        } else {
+            CHECK(publisher.publish(Event("ledger", std::to_string(i)), key));
+            if (i % 100 == 99) {
+                CHECK(publisher.flush());
+            }
+        }
+    }
+
+    const std::vector<Event> events = poll_all(merging_consumer(event_bus), 1000);
+    CHECK(events.size() == 1000);
+    std::vector<int> last_by_key(13, -1);
+    for (size_t i = 0; i < events.size(); ++i) {
+        CHECK(events[i].sequence == i + 1);
+        const int published = std::stoi(events[i].payload);
+        if (i % 100 < 50) {
+            CHECK(published == static_cast<int>(i));
+        } else {
+            CHECK(published / 100 == static_cast<int>(i / 100) && published % 100 >= 50);
+        }
+        CHECK(published > last_by_key[published % 13]);
+        last_by_key[published % 13] = published;
+    }
+}
+
+// Racing producers still get one gap free sequence, and each producer's events keep their order in it
+static void racing_producers_are_sequenced() {
+    constexpr int PRODUCERS = 4;
+    constexpr int EVENTS_PER_PRODUCER = 1500;
+    EventBus event_bus(ledger_config(true));
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < PRODUCERS; ++producer) {
+        producers.emplace_back([&event_bus, producer] {
+            for (int i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+                const std::string payload = std::to_string(producer) + ":" + std::to_string(i);
+                CHECK(event_bus.publish_event(Event("ledger", payload), "key_" + std::to_string(i % 7)));
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    const std::vector<Event> events = poll_all(merging_consumer(event_bus), PRODUCERS * EVENTS_PER_PRODUCER);
+    CHECK(events.size() == PRODUCERS * EVENTS_PER_PRODUCER);
+    std::vector<int> next_by_producer(PRODUCERS, 0);
+    for (size_t i = 0; i < events.size(); ++i) {
+        CHECK(events[i].sequence == i + 1);
+        const size_t colon = events[i].payload.find(':');
+        const int producer = std::stoi(events[i].payload.substr(0, colon));
+        CHECK(std::stoi(events[i].payload.substr(colon + 1)) == next_by_producer[producer]++);
+    }
+}
+
+static void plain_topics_are_not_sequenced() {
+    EventBus event_bus(ledger_config(false));
+    CHECK(event_bus.publish_event(Event("ledger", "entry"), "account_1"));
+    const auto& events = event_bus.consumers_by_consumer_group_id().at("audit")[0]->poll_batch(10);
+    CHECK(events.size() == 1);
+    CHECK(events[0].sequence == Event::NO_SEQUENCE);
+}
+
+int main() {
+    single_publishes_and_flushes_share_the_sequence();
+    racing_producers_are_sequenced();
+    plain_topics_are_not_sequenced();
+    return 0;
+}